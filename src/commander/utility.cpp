@@ -73,6 +73,15 @@ TransactionInfo::TransactionInfo(TransactionLog const& transaction_log)
 
         break;
     }
+    case CompactServiceStatistics::rtt:
+    {
+        CompactServiceStatistics const* compact_statistics;
+        transaction_log.action.get(compact_statistics);
+
+        from = compact_statistics->server_address;
+
+        break;
+    }
     case SponsorContentUnit::rtt:
     {
         SponsorContentUnit const* sponsor_content_unit;
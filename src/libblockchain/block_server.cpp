@@ -0,0 +1,320 @@
+#include "block_server.hpp"
+#include "blockchain.hpp"
+#include "common.hpp"
+
+#include <mesh.pp/cryptoutility.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+using namespace BlockchainMessage;
+using std::string;
+using std::vector;
+
+namespace publiqpp
+{
+namespace detail
+{
+class block_server_internals
+{
+public:
+    block_server_internals(boost::filesystem::path const& fs_blockchain,
+                           beltpp::event_handler& eh)
+        : m_fs_blockchain(fs_blockchain)
+        , m_peh(&eh)
+    {}
+
+    void run()
+    {
+        while (true)
+        {
+            std::pair<beltpp::isocket::peer_id, BlockchainRequest> request;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this]
+                {
+                    return m_stop || false == m_requests.empty();
+                });
+
+                if (m_stop)
+                    return;
+
+                request = std::move(m_requests.front());
+                m_requests.pop_front();
+            }
+
+            block_server::response response;
+            response.first = std::move(request.first);
+
+            string error;
+            bool served = false;
+            for (size_t attempt = 0; false == served && attempt != BLOCK_SERVER_ATTEMPTS; ++attempt)
+            {
+                try
+                {
+                    served = serve(request.second, response.second);
+                    if (false == served)
+                        error = "the blockchain changed while serving";
+                }
+                catch (std::exception const& ex)
+                {
+                    error = ex.what();
+                }
+                catch (...)
+                {
+                    error = "unknown exception";
+                }
+
+                //  whatever the reader holds may be half of a commit
+                if (false == served)
+                    m_reader.reset();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                //  the peer is gone meanwhile
+                auto it_peer = m_peer_requests.find(response.first);
+                if (it_peer == m_peer_requests.end())
+                    continue;
+
+                //  the peer will time out and ask someone else
+                if (served)
+                    m_responses.push_back(std::move(response));
+                else
+                {
+                    release(it_peer);
+                    m_errors.push_back("block server could not serve " +
+                                       std::to_string(request.second.blocks_from) + " - " +
+                                       std::to_string(request.second.blocks_to) + ": " + error);
+                }
+            }
+            m_peh->wake();
+        }
+    }
+
+    //  false if a commit of the blockchain files overlapped with the reading
+    bool serve(BlockchainRequest const& blockchain_request,
+               BlockchainResponse& chain_response)
+    {
+        uint64_t length;
+        string last_hash;
+        uint64_t sequence;
+        uint64_t revert_generation;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            length = m_length;
+            last_hash = m_last_hash;
+            sequence = m_sequence;
+            revert_generation = m_revert_generation;
+        }
+
+        //  odd while a commit is in progress
+        if (sequence % 2)
+            return false;
+
+        chain_response.signed_blocks.clear();
+        if (0 == length)
+            return true;
+
+        // blocks are always requested in regular order
+
+        uint64_t number = length - 1;
+        uint64_t from = number < blockchain_request.blocks_from ? number : blockchain_request.blocks_from;
+
+        uint64_t to = blockchain_request.blocks_to;
+        to = to < from ? from : to;
+        to = to > from + BLOCK_TR_MAX_LENGTH ? from + BLOCK_TR_MAX_LENGTH : to;
+        to = to > number ? number : to;
+
+        //  the reader stays valid while the blockchain only grows,
+        //  it is opened again to see the newer blocks or after a revert
+        if (nullptr == m_reader ||
+            m_reader_revert_generation != revert_generation ||
+            m_reader->length() <= to)
+        {
+            m_reader.reset();
+            m_reader.reset(new blockchain(m_fs_blockchain));
+            m_reader_revert_generation = revert_generation;
+        }
+
+        if (m_reader->length() <= to)
+            return false;
+
+        uint64_t transactions_count = 0;
+        for (auto i = from; i <= to && transactions_count < BLOCK_TR_MAX_TRANSACTIONS; ++i)
+        {
+            SignedBlock const& signed_block = m_reader->at(i);
+            transactions_count += signed_block.block_details.signed_transactions.size();
+
+            chain_response.signed_blocks.push_back(signed_block);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (sequence != m_sequence)
+            return false;
+
+        if (chain_response.signed_blocks.back().block_details.header.block_number == number &&
+            meshpp::hash(chain_response.signed_blocks.back().block_details.to_string()) != last_hash)
+            return false;
+
+        return true;
+    }
+
+    //  called with m_mutex held
+    void release(std::unordered_map<beltpp::isocket::peer_id, size_t>::iterator it_peer)
+    {
+        if (0 == --it_peer->second)
+            m_peer_requests.erase(it_peer);
+    }
+
+    boost::filesystem::path m_fs_blockchain;
+    beltpp::event_handler* m_peh;
+
+    //  guards everything below, except the reader which is the thread's own
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop = false;
+    uint64_t m_length = 0;
+    string m_last_hash;
+    uint64_t m_sequence = 0;
+    uint64_t m_revert_generation = 0;
+    bool m_removed = false;
+    std::deque<std::pair<beltpp::isocket::peer_id, BlockchainRequest>> m_requests;
+    //  requests per peer, from request until the response is taken
+    std::unordered_map<beltpp::isocket::peer_id, size_t> m_peer_requests;
+    vector<block_server::response> m_responses;
+    vector<string> m_errors;
+
+    std::unique_ptr<blockchain> m_reader;
+    uint64_t m_reader_revert_generation = 0;
+
+    std::thread m_thread;
+};
+}
+
+block_server::block_server(boost::filesystem::path const& fs_blockchain,
+                           beltpp::event_handler& eh)
+    : m_pimpl(new detail::block_server_internals(fs_blockchain, eh))
+{
+    auto* pimpl = m_pimpl.get();
+    m_pimpl->m_thread = std::thread([pimpl]{ pimpl->run(); });
+}
+
+block_server::~block_server()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pimpl->m_mutex);
+        m_pimpl->m_stop = true;
+    }
+    m_pimpl->m_condition.notify_one();
+    m_pimpl->m_thread.join();
+}
+
+void block_server::committing(uint64_t length, string const& last_hash)
+{
+    std::lock_guard<std::mutex> lock(m_pimpl->m_mutex);
+
+    //  most commits are about the transaction pool only
+    if (m_pimpl->m_length == length &&
+        m_pimpl->m_last_hash == last_hash &&
+        false == m_pimpl->m_removed)
+        return;
+
+    if (m_pimpl->m_removed ||
+        length < m_pimpl->m_length)
+        ++m_pimpl->m_revert_generation;
+
+    m_pimpl->m_removed = false;
+    m_pimpl->m_length = length;
+    m_pimpl->m_last_hash = last_hash;
+    ++m_pimpl->m_sequence;
+}
+
+void block_server::committed()
+{
+    std::lock_guard<std::mutex> lock(m_pimpl->m_mutex);
+
+    if (m_pimpl->m_sequence % 2)
+        ++m_pimpl->m_sequence;
+}
+
+void block_server::removed()
+{
+    std::lock_guard<std::mutex> lock(m_pimpl->m_mutex);
+    m_pimpl->m_removed = true;
+}
+
+bool block_server::request(beltpp::isocket::peer_id const& peerid,
+                           BlockchainRequest const& blockchain_request)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pimpl->m_mutex);
+
+        auto& peer_requests = m_pimpl->m_peer_requests[peerid];
+        if (peer_requests == BLOCK_SERVER_PEER_REQUESTS)
+            return false;
+
+        ++peer_requests;
+        m_pimpl->m_requests.push_back(std::make_pair(peerid, blockchain_request));
+    }
+    m_pimpl->m_condition.notify_one();
+
+    return true;
+}
+
+void block_server::remove_peer(beltpp::isocket::peer_id const& peerid)
+{
+    std::lock_guard<std::mutex> lock(m_pimpl->m_mutex);
+
+    auto& requests = m_pimpl->m_requests;
+    requests.erase(std::remove_if(requests.begin(), requests.end(),
+                                  [&peerid](std::pair<beltpp::isocket::peer_id, BlockchainRequest> const& item)
+                                  {
+                                      return item.first == peerid;
+                                  }),
+                   requests.end());
+
+    auto& responses = m_pimpl->m_responses;
+    responses.erase(std::remove_if(responses.begin(), responses.end(),
+                                   [&peerid](response const& item)
+                                   {
+                                       return item.first == peerid;
+                                   }),
+                    responses.end());
+
+    //  the one being served now is thrown away when done
+    m_pimpl->m_peer_requests.erase(peerid);
+}
+
+vector<block_server::response> block_server::take_responses()
+{
+    vector<response> result;
+
+    std::lock_guard<std::mutex> lock(m_pimpl->m_mutex);
+    result.swap(m_pimpl->m_responses);
+
+    for (auto const& item : result)
+    {
+        auto it_peer = m_pimpl->m_peer_requests.find(item.first);
+        if (it_peer != m_pimpl->m_peer_requests.end())
+            m_pimpl->release(it_peer);
+    }
+
+    return result;
+}
+
+vector<string> block_server::take_errors()
+{
+    vector<string> result;
+
+    std::lock_guard<std::mutex> lock(m_pimpl->m_mutex);
+    result.swap(m_pimpl->m_errors);
+
+    return result;
+}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "global.hpp"
+#include "message.hpp"
+
+#include <belt.pp/isocket.hpp>
+#include <belt.pp/event.hpp>
+
+#include <boost/filesystem/path.hpp>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace publiqpp
+{
+namespace detail
+{
+class block_server_internals;
+}
+
+//  answers block requests on its own thread, reading the committed blockchain
+//  through a separate read-only instance, so that serving syncing peers does
+//  not hold back the node loop
+//  the reads do not block commits, a read that overlapped with a commit of
+//  the blockchain files is thrown away and done again
+class block_server
+{
+public:
+    using response = std::pair<beltpp::isocket::peer_id, BlockchainMessage::BlockchainResponse>;
+
+    block_server(boost::filesystem::path const& fs_blockchain,
+                 beltpp::event_handler& eh);
+    ~block_server();
+
+    //  bracket the commit of the blockchain files, length and last hash
+    //  are the ones being committed
+    //  the loaders' save() before this writes the pending changes aside
+    //  and only their commit() puts them in place, which is why commit()
+    //  cannot fail, so the committed files do not change before this
+    void committing(uint64_t length, std::string const& last_hash);
+    void committed();
+    //  a block was removed, the next commit replaces blocks on disk
+    void removed();
+
+    //  false if the peer has too many requests waiting already
+    bool request(beltpp::isocket::peer_id const& peerid,
+                 BlockchainMessage::BlockchainRequest const& blockchain_request);
+    //  its requests and responses are dropped
+    void remove_peer(beltpp::isocket::peer_id const& peerid);
+    std::vector<response> take_responses();
+    std::vector<std::string> take_errors();
+
+private:
+    std::unique_ptr<detail::block_server_internals> m_pimpl;
+};
+}
@@ -6,6 +6,10 @@
 #include <mesh.pp/fileutility.hpp>
 #include <mesh.pp/cryptoutility.hpp>
 
+#include <deque>
+#include <map>
+#include <utility>
+
 using namespace BlockchainMessage;
 namespace filesystem = boost::filesystem;
 
@@ -19,13 +23,27 @@ public:
     blockchain_internals(filesystem::path const& path)
         : m_header("header", path, 1000, 1, detail::get_putl())
         , m_blockchain("block", path, 10000, 1, detail::get_putl())
+        , m_recent_headers_from(0)
+    {
+    }
+
+    void clear_caches()
     {
+        m_recent_headers.clear();
+        m_recent_headers_from = 0;
+        m_header_responses.clear();
     }
 
     std::string m_last_hash;
     BlockHeader m_last_header;
     meshpp::vector_loader<BlockHeader> m_header;
     meshpp::vector_loader<SignedBlock> m_blockchain;
+
+    //  extended headers of the recent blocks, up to the last one
+    std::deque<BlockHeaderExtended> m_recent_headers;
+    uint64_t m_recent_headers_from;
+    //  header responses by (from, to), those do not change until a revert
+    std::map<std::pair<uint64_t, uint64_t>, BlockHeaderResponse> m_header_responses;
 };
 }
 
@@ -54,6 +72,7 @@ void blockchain::discard() noexcept
 {
     m_pimpl->m_header.discard();
     m_pimpl->m_blockchain.discard();
+    m_pimpl->clear_caches();
 
     if (length() > 0)
         update_state();
@@ -63,6 +82,7 @@ void blockchain::clear()
 {
     m_pimpl->m_header.clear();
     m_pimpl->m_blockchain.clear();
+    m_pimpl->clear_caches();
 }
 
 void blockchain::update_state()
@@ -120,6 +140,17 @@ void blockchain::insert(SignedBlock const& signed_block)
     m_pimpl->m_blockchain.push_back(signed_block);
 
     update_state();
+
+    auto& recent_headers = m_pimpl->m_recent_headers;
+    if (false == recent_headers.empty())
+    {
+        recent_headers.push_back(last_header_ex());
+        if (recent_headers.size() > HEADER_CACHE_LENGTH)
+        {
+            recent_headers.pop_front();
+            ++m_pimpl->m_recent_headers_from;
+        }
+    }
 }
 
 BlockchainMessage::SignedBlock const& blockchain::at(uint64_t number) const
@@ -132,6 +163,50 @@ BlockHeader const& blockchain::header_at(uint64_t number) const
     return m_pimpl->m_header.as_const().at(number);
 }
 BlockHeaderExtended blockchain::header_ex_at(uint64_t number) const
+{
+    auto& recent_headers = m_pimpl->m_recent_headers;
+    uint64_t const blockchain_length = length();
+
+    if (recent_headers.empty() &&
+        number < blockchain_length &&
+        number + HEADER_CACHE_LENGTH >= blockchain_length)
+    {
+        //  fill the recent headers once, then insert and remove keep them
+        m_pimpl->m_recent_headers_from = blockchain_length > HEADER_CACHE_LENGTH ?
+                                             blockchain_length - HEADER_CACHE_LENGTH : 0;
+        for (uint64_t index = m_pimpl->m_recent_headers_from; index != blockchain_length; ++index)
+            recent_headers.push_back(read_header_ex(index));
+    }
+
+    if (number >= m_pimpl->m_recent_headers_from &&
+        number - m_pimpl->m_recent_headers_from < recent_headers.size())
+        return recent_headers[number - m_pimpl->m_recent_headers_from];
+
+    return read_header_ex(number);
+}
+
+BlockHeaderResponse const& blockchain::header_response(uint64_t from, uint64_t to) const
+{
+    auto& header_responses = m_pimpl->m_header_responses;
+    auto key = std::make_pair(from, to);
+
+    auto it = header_responses.find(key);
+    if (it != header_responses.end())
+        return it->second;
+
+    if (header_responses.size() >= HEADER_RESPONSE_CACHE_SIZE)
+        header_responses.clear();
+
+    //  block_headers has highest index - first element
+    //                and lowest index - last element
+    BlockHeaderResponse header_response;
+    for (auto index = from + 1; index > to; --index)
+        header_response.block_headers.push_back(header_ex_at(index - 1));
+
+    return header_responses.insert(std::make_pair(key, std::move(header_response))).first->second;
+}
+
+BlockHeaderExtended blockchain::read_header_ex(uint64_t number) const
 {
     BlockHeaderExtended result;
     if (number != m_pimpl->m_blockchain.size() - 1)
@@ -161,5 +236,20 @@ void blockchain::remove_last_block()
     m_pimpl->m_blockchain.pop_back();
 
     update_state();
+
+    //  the responses reaching the removed block are not valid anymore
+    uint64_t const blockchain_length = length();
+    auto& header_responses = m_pimpl->m_header_responses;
+    for (auto it = header_responses.begin(); it != header_responses.end();)
+    {
+        if (it->first.first >= blockchain_length)
+            it = header_responses.erase(it);
+        else
+            ++it;
+    }
+
+    auto& recent_headers = m_pimpl->m_recent_headers;
+    if (false == recent_headers.empty())
+        recent_headers.pop_back();
 }
 }
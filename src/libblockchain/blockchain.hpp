@@ -38,8 +38,11 @@ public:
     BlockchainMessage::SignedBlock const& at(uint64_t number) const;
     BlockchainMessage::BlockHeader const& header_at(uint64_t number) const;
     BlockchainMessage::BlockHeaderExtended header_ex_at(uint64_t number) const;
+    BlockchainMessage::BlockHeaderResponse const& header_response(uint64_t from, uint64_t to) const;
     void remove_last_block();
 private:
+    BlockchainMessage::BlockHeaderExtended read_header_ex(uint64_t number) const;
+
     std::unique_ptr<detail::blockchain_internals> m_pimpl;
 };
 
@@ -5,29 +5,16 @@
 
 namespace publiqpp
 {
-coin::coin()
-    : whole(0)
-    , fraction(0)
-{}
-
-coin::coin(coin const& other)
-    : whole(other.whole)
-    , fraction(other.fraction)
-{}
-
-coin::coin(uint64_t whole, uint64_t fraction)
-    : whole(whole)
-    , fraction(fraction)
+uint64_t coin::invalid_amount(uint64_t whole, uint64_t fraction)
 {
-    if (fraction >= fractions_in_whole)
-        throw std::runtime_error("invalid coin amount: (" +
-                                 std::to_string(whole) + ", " +
-                                 std::to_string(fraction) + ")");
+    throw std::runtime_error("invalid coin amount: (" +
+                             std::to_string(whole) + ", " +
+                             std::to_string(fraction) + ")");
 }
 
-uint64_t coin::to_uint64_t() const
+void coin::overflow()
 {
-    return fractions_in_whole * whole + fraction;
+    throw std::runtime_error("coin amount overflow");
 }
 
 std::string coin::to_string() const
@@ -35,148 +22,77 @@ std::string coin::to_string() const
     return "(" + std::to_string(whole) + "," + std::to_string(fraction) + ")";
 }
 
-bool coin::empty() const
+void coin::multiply(uint64_t times)
 {
-    return (whole == 0) && (fraction == 0);
-}
-
-coin& coin::operator = (coin const& other)
-{
-    whole = other.whole;
-    fraction = other.fraction;
-
-    return *this;
-}
-
-coin& coin::operator += (coin const& other)
-{
-    fraction += other.fraction;
-
-    if (fraction >= fractions_in_whole)
-    {
-        ++whole;
-        fraction -= fractions_in_whole;
-    }
-
-    whole += other.whole;
-
-    return *this;
-}
-
-coin& coin::operator -= (coin const& other)
-{
-    if (    whole < other.whole ||
-            (
-                whole == other.whole &&
-                fraction < other.fraction
-            )
-       )
-        throw std::runtime_error("cannot have negative result for coin");
-
-    if (fraction < other.fraction)
-    {
-        --whole;
-        fraction += fractions_in_whole;
-    }
-
-    fraction -= other.fraction;
-
-    whole -= other.whole;
-
-    return *this;
-}
-
-coin& coin::operator *= (uint64_t times)
-{
-    whole *= times;
-    fraction *= times;
-    whole += fraction / fractions_in_whole;
-    fraction = fraction % fractions_in_whole;
-
-    return *this;
-}
+    uint64_t const max = std::numeric_limits<uint64_t>::max();
 
-coin& coin::operator /= (uint64_t  times)
-{
-    if (0 == times) throw std::runtime_error("zero division");
+    //  fraction * times = fraction * times_whole * fractions_in_whole +
+    //                     fraction * times_fraction
+    uint64_t times_whole = times / fractions_in_whole;
+    uint64_t times_fraction = times % fractions_in_whole;
 
-    fraction += whole % times * fractions_in_whole;
-    whole /= times;
-    fraction /= times;
+    uint64_t product_fraction = fraction * times_fraction;
+    uint64_t carry = product_fraction / fractions_in_whole;
 
-    return *this;
-}
+    if (times_whole != 0 && fraction > max / times_whole)
+        overflow();
+    uint64_t high = fraction * times_whole;
 
-coin& coin::operator %= (uint64_t  times)
-{
-     *this -= (*this / times) * times;
-     return *this;
-}
+    if (high > max - carry)
+        overflow();
+    carry += high;
 
-bool coin::operator > (coin const& other) const
-{
-    if (whole > other.whole ||
-            (
-                whole == other.whole &&
-                fraction > other.fraction
-            )
-       )
-        return true;
-
-    return false;
-}
+    if (times != 0 && whole > max / times)
+        overflow();
+    uint64_t product_whole = whole * times;
 
-bool coin::operator < (coin const& other) const
-{
-    return other > *this;
-}
+    if (product_whole > max - carry)
+        overflow();
 
-bool coin::operator >= (coin const& other) const
-{
-    return !(other > *this);
+    whole = product_whole + carry;
+    fraction = product_fraction % fractions_in_whole;
 }
 
-bool coin::operator <= (coin const& other) const
+uint64_t coin::divide_rest(uint64_t rest, uint64_t times) const
 {
-    return !(*this > other);
-}
+    //  (rest * fractions_in_whole + fraction) / times in 128 bits,
+    //  rest < times so the quotient is below fractions_in_whole
+    uint64_t const low_mask = 0xffffffff;
 
-bool coin::operator == (coin const& other) const
-{
-    return !(*this > other) && !(other > *this);
-}
-bool coin::operator != (coin const& other) const
-{
-    return (*this > other) || (other > *this);
-}
+    uint64_t rest_low = rest & low_mask;
+    uint64_t rest_high = rest >> 32;
 
-coin operator + (coin first, coin const& second)
-{
-    first += second;
-    return first;
-}
+    uint64_t product_low = rest_low * fractions_in_whole;
+    uint64_t product_middle = rest_high * fractions_in_whole;
 
-coin operator - (coin first, coin const& second)
-{
-    first -= second;
-    return first;
-}
+    uint64_t dividend_high = product_middle >> 32;
+    uint64_t dividend_low = product_low + (product_middle << 32);
+    if (dividend_low < product_low)
+        ++dividend_high;
 
-coin operator * (coin first, uint64_t  times)
-{
-    first *= times;
-    return first;
-}
+    dividend_low += fraction;
+    if (dividend_low < fraction)
+        ++dividend_high;
 
-coin operator / (coin first, uint64_t  times)
-{
-    first /= times;
-    return first;
-}
+    uint64_t quotient = 0;
+    uint64_t remainder = 0;
+    for (int bit = 127; bit >= 0; --bit)
+    {
+        uint64_t next = bit >= 64 ?
+                            (dividend_high >> (bit - 64)) & 1 :
+                            (dividend_low >> bit) & 1;
+
+        bool carry = (remainder >> 63) != 0;
+        remainder = (remainder << 1) | next;
+        quotient <<= 1;
+
+        if (carry || remainder >= times)
+        {
+            remainder -= times;
+            quotient |= 1;
+        }
+    }
 
-coin operator % (coin first, uint64_t  times)
-{
-    first %= times;
-    return first;
+    return quotient;
 }
 }// end namespace publiqpp
@@ -2,18 +2,29 @@
 
 #include "global.hpp"
 
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
 #include <string>
 
 namespace publiqpp
 {
+//  fixed point amount, whole part and fraction in 1/fractions_in_whole units
+//  together they hold 64 + 27 bits, every operation is exact or throws
 class BLOCKCHAINSHARED_EXPORT coin
 {
 public:
-    coin();
-    coin(coin const& other);
-    coin(uint64_t whole, uint64_t fraction);
+    constexpr coin()
+        : whole(0)
+        , fraction(0)
+    {}
+    constexpr coin(coin const& other) = default;
+    constexpr coin(uint64_t whole, uint64_t fraction)
+        : whole(whole)
+        , fraction(fraction < fractions_in_whole ? fraction : invalid_amount(whole, fraction))
+    {}
     template <typename Coin>
-    coin(Coin const& other)
+    constexpr coin(Coin const& other)
         : coin(other.whole, other.fraction) {}
 
     uint64_t to_uint64_t() const;
@@ -25,9 +36,12 @@ public:
     }
 
     std::string to_string() const;
-    bool empty() const;
+    constexpr bool empty() const
+    {
+        return (whole == 0) && (fraction == 0);
+    }
 
-    coin& operator = (coin const& other);
+    coin& operator = (coin const& other) = default;
     coin& operator += (coin const& other);
     coin& operator -= (coin const& other);
 
@@ -35,25 +49,157 @@ public:
     coin& operator /= (uint64_t times);
     coin& operator %= (uint64_t times);
 
-    bool operator > (coin const& other) const;
-    bool operator < (coin const& other) const;
-    bool operator >= (coin const& other) const;
-    bool operator <= (coin const& other) const;
+    constexpr bool operator > (coin const& other) const
+    {
+        return whole > other.whole ||
+               (whole == other.whole && fraction > other.fraction);
+    }
+    constexpr bool operator < (coin const& other) const
+    {
+        return other > *this;
+    }
+    constexpr bool operator >= (coin const& other) const
+    {
+        return false == (other > *this);
+    }
+    constexpr bool operator <= (coin const& other) const
+    {
+        return false == (*this > other);
+    }
 
-    bool operator == (coin const& other) const;
-    bool operator != (coin const& other) const;
+    constexpr bool operator == (coin const& other) const
+    {
+        return whole == other.whole && fraction == other.fraction;
+    }
+    constexpr bool operator != (coin const& other) const
+    {
+        return false == (*this == other);
+    }
 
     static const uint64_t fractions_in_whole = 100000000;
 
 private:
+    static uint64_t invalid_amount(uint64_t whole, uint64_t fraction);
+    static void overflow();
+
+    //  the exact forms for the operands the inline checks cannot handle
+    void multiply(uint64_t times);
+    uint64_t divide_rest(uint64_t rest, uint64_t times) const;
+
     uint64_t whole;
     uint64_t fraction;
 };
 
-BLOCKCHAINSHARED_EXPORT coin operator + (coin first, coin const& second);
-BLOCKCHAINSHARED_EXPORT coin operator - (coin first, coin const& second);
+inline uint64_t coin::to_uint64_t() const
+{
+    return fractions_in_whole * whole + fraction;
+}
+
+inline coin& coin::operator += (coin const& other)
+{
+    uint64_t sum_fraction = fraction + other.fraction;
+    uint64_t carry = 0;
+    if (sum_fraction >= fractions_in_whole)
+    {
+        carry = 1;
+        sum_fraction -= fractions_in_whole;
+    }
 
-BLOCKCHAINSHARED_EXPORT coin operator * (coin first, uint64_t  times);
-BLOCKCHAINSHARED_EXPORT coin operator / (coin first, uint64_t  times);
-BLOCKCHAINSHARED_EXPORT coin operator % (coin first, uint64_t  times);
+    uint64_t const max = std::numeric_limits<uint64_t>::max();
+    if (whole > max - carry ||
+        other.whole > max - carry - whole)
+        overflow();
+
+    whole += other.whole + carry;
+    fraction = sum_fraction;
+
+    return *this;
+}
+
+inline coin& coin::operator -= (coin const& other)
+{
+    if (other > *this)
+        throw std::runtime_error("cannot have negative result for coin");
+
+    if (fraction < other.fraction)
+    {
+        --whole;
+        fraction += fractions_in_whole;
+    }
+
+    fraction -= other.fraction;
+    whole -= other.whole;
+
+    return *this;
+}
+
+inline coin& coin::operator *= (uint64_t times)
+{
+    //  with 32 bit operands neither the product nor the carry can overflow
+    if (0 == ((whole | times) >> 32))
+    {
+        uint64_t product_fraction = fraction * times;
+        whole = whole * times + product_fraction / fractions_in_whole;
+        fraction = product_fraction % fractions_in_whole;
+    }
+    else
+        multiply(times);
+
+    return *this;
+}
+
+inline coin& coin::operator /= (uint64_t times)
+{
+    if (0 == times)
+        throw std::runtime_error("zero division");
+
+    uint64_t rest = whole % times;
+    whole /= times;
+
+    if (rest <= (std::numeric_limits<uint64_t>::max() - fractions_in_whole) / fractions_in_whole)
+        fraction = (rest * fractions_in_whole + fraction) / times;
+    else
+        fraction = divide_rest(rest, times);
+
+    return *this;
+}
+
+inline coin& coin::operator %= (uint64_t times)
+{
+    coin part = *this;
+    part /= times;
+    part *= times;
+
+    return *this -= part;
+}
+
+inline coin operator + (coin first, coin const& second)
+{
+    first += second;
+    return first;
+}
+
+inline coin operator - (coin first, coin const& second)
+{
+    first -= second;
+    return first;
+}
+
+inline coin operator * (coin first, uint64_t times)
+{
+    first *= times;
+    return first;
+}
+
+inline coin operator / (coin first, uint64_t times)
+{
+    first /= times;
+    return first;
+}
+
+inline coin operator % (coin first, uint64_t times)
+{
+    first %= times;
+    return first;
+}
 }// end namespace publiqpp
@@ -19,6 +19,31 @@
 #define BLOCK_TR_LENGTH 9
 #define HEADER_TR_LENGTH 49
 
+// Sync batches start from the lengths above and adapt per peer
+// up to these, which are also the max served to a single request
+#define BLOCK_TR_MAX_LENGTH 49
+#define HEADER_TR_MAX_LENGTH 499
+// Max transactions served per blocks request, at least one block is served
+#define BLOCK_TR_MAX_TRANSACTIONS (10 * BLOCK_MAX_TRANSACTIONS)
+// Reads of a blocks request redone when commits overlap with them
+#define BLOCK_SERVER_ATTEMPTS 3
+// Blocks requests of a peer waiting or being served, the ones above are refused
+#define BLOCK_SERVER_PEER_REQUESTS 2
+// Sync batch doubles when a full batch responded faster than this and
+// halves when a response is slower than this, in milliseconds
+#define SYNC_BATCH_FAST_RESPONSE 1000
+#define SYNC_BATCH_SLOW_RESPONSE 5000
+// Blocks ahead of the block sync session that other peers may prefetch
+#define SYNC_PARALLEL_WINDOW (2 * BLOCK_INSERT_LENGTH)
+// A compact block not answered within this many milliseconds
+// is requested in full, the peer is not asked for compact ones again
+#define COMPACT_BLOCK_TIMEOUT 3000
+
+// Recent extended headers kept in memory and
+// the count of header responses cached for the hot ranges
+#define HEADER_CACHE_LENGTH (2 * (HEADER_TR_MAX_LENGTH + 1))
+#define HEADER_RESPONSE_CACHE_SIZE 16
+
 // Maximum buffer length of blocks
 // that can be collected per sync
 #define BLOCK_INSERT_LENGTH 50
@@ -40,6 +65,38 @@
 
 // Max chunk size of files to request and process at a time
 #define STORAGE_MAX_FILE_REQUESTS 100
+// Max files to request from a single channel at a time
+#define STORAGE_MAX_CHANNEL_FILE_REQUESTS 10
+// Max unresolved channels to keep the file requests for
+#define STORAGE_MAX_UNRESOLVED_CHANNELS 10
+
+// File data size transferred per one chunk during replication
+// and the max file size accepted from a channel
+#define STORAGE_FILE_CHUNK_SIZE (1024 * 1024)
+#define STORAGE_MAX_FILE_SIZE (1024 * 1024 * 30)
+// Seconds to ask a channel for whole files after it did not serve a chunk,
+// then the chunked transfer is tried again
+#define STORAGE_WHOLE_FILE_CHANNEL_SECONDS 3600
+
+// Files stored as a whole, before the chunk store, are decoded once
+// and kept for the next chunk requests, this many most recent ones
+#define STORAGE_DECODED_FILES_CACHE 4
+
+// Content defined chunk sizes used for deduplicated file storage
+// changing these does not break stored files, only worsens dedup
+#define STORAGE_DEDUP_CHUNK_MIN_SIZE (16 * 1024)
+#define STORAGE_DEDUP_CHUNK_AVG_BITS 16
+#define STORAGE_DEDUP_CHUNK_MAX_SIZE (256 * 1024)
+
+// Local files not assigned to the storage are deleted after being seen
+// unassigned for the grace period, a few files per check timer tick
+#define STORAGE_GC_GRACE_PERIOD (3600 * 24)
+#define STORAGE_GC_BATCH 10
+
+// Max file uris listed in one page, pages go in uri order
+#define STORAGE_FILE_URIS_PAGE_SIZE 10000
+// Leading uri characters the stored uri index is bucketed by
+#define STORAGE_URI_INDEX_PREFIX 2
 
 // Timers in seconds
 #define CHECK_TIMER 1
@@ -48,15 +105,46 @@
 #define BROADCAST_TIMER 1800
 #define CACHE_CLEANUP_TIMER 300
 #define SUMMARY_REPORT_TIMER 1800
+#define STORAGE_GC_TIMER 3600
 
 #define TRANSACTION_MAX_LIFETIME_HOURS 24
 
+// Outbound bytes a peer's socket is handed per second, also the most it
+// gets at once, the packets above that wait in the peer's queue
+#define SEND_QUEUE_PEER_BYTES_PER_SECOND (16*1024*1024)
+// Queued bytes after which a peer counts as congested
+#define SEND_QUEUE_CONGESTED_BYTES (16*1024*1024)
+
+// Threads checking the signatures of received transactions
+#define TRANSACTION_VERIFIER_MAX_THREADS 4
+// Checked transactions remembered until the node loop processes them
+#define TRANSACTION_VERIFIER_MAX_VERIFIED 100000
+
+// Transaction hashes announced or requested in one message
+#define TRANSACTION_INVENTORY_MAX_LENGTH 1000
+// Seconds to wait for an announcing peer to send the transaction
+#define TRANSACTION_INVENTORY_REQUEST_TIMEOUT 10
+// Seconds to remember which peers know a transaction
+#define TRANSACTION_INVENTORY_LIFETIME BROADCAST_TIMER
+// Transactions a peer may announce before it delivers any of them,
+// further unknown hashes from that peer are ignored
+#define TRANSACTION_INVENTORY_MAX_UNSOLICITED 10000
+
+// Blocks for which the validated service statistics are remembered
+#define STATISTICS_CACHE_MAX_LENGTH 16
+
 // Maximum time shift on seconds
 // acceptable between nodes
 #define NODES_TIME_SHIFT 60
 
+// Seconds of counter expiry time grouped together by the service counter
+#define SERVICE_COUNTER_BUCKET_SECONDS 60
+
 #define PUBLIC_ADDRESS_FRESH_THRESHHOLD_SECONDS 600
 
+// Seconds between rereads of the public address book for voting
+#define VOTER_INDEX_REFRESH_SECONDS 60
+
 // Consensus delta definitions
 #define DELTA_STEP  3ull
 #define DELTA_MAX   7000000000ull
@@ -65,6 +153,17 @@
 
 #define DIST_MAX    4294967296ull
 
+// Blocks for which the sponsored usage before rewards is kept for reverting
+#define SPONSORED_UNDO_MAX_BLOCKS 1000
+
+// Block number from which CompactServiceStatistics is accepted on mainnet
+// not scheduled yet, to be set to the height agreed on for the next fork
+// until then only testnet accepts it
+#define COMPACT_STATISTICS_ACTIVATION_BLOCK uint64_t(-1)
+
+// Threads cross verifying the service statistics of one block
+#define STATISTICS_VALIDATION_MAX_THREADS 4
+
 // Service statistics acceptable discreancy
 #define STAT_ERROR_LIMIT 1.2
 
@@ -1,6 +1,8 @@
 #include "communication_p2p.hpp"
 #include "communication_rpc.hpp"
+#include "statistics_aggregation.hpp"
 #include "transaction_handler.hpp"
+#include "transaction_statinfo.hpp"
 
 #include "coin.hpp"
 #include "common.hpp"
@@ -16,6 +18,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <chrono>
+#include <thread>
 
 using namespace BlockchainMessage;
 
@@ -80,11 +83,6 @@ void revert_transaction(SignedTransaction const& signed_transaction,
                   layer);
 }
 
-bool stat_mismatch(uint64_t first, uint64_t second)
-{
-    return std::max(first, second) > std::min(first, second) * STAT_ERROR_LIMIT;
-}
-
 void validate_statistics(map<string, ServiceStatistics> const& channel_provided_statistics,
                          map<string, ServiceStatistics> const& storage_provided_statistics,
                          multimap<string, pair<uint64_t, uint64_t>>& author_result,
@@ -95,62 +93,15 @@ void validate_statistics(map<string, ServiceStatistics> const& channel_provided_
                          uint64_t block_number,
                          publiqpp::detail::node_internals& impl)
 {
-    author_result.clear();
-    channel_result.clear();
-    storage_result.clear();
-
-    map_unit_uri_view_counts.clear();
-
-    map<string, map<string, map<string, uint64_t>>> channel_statistics;
-    map<string, map<string, set<string>>> cross_verified_statistics;
-
     unordered_set<string> file_uris, unit_uris;
 
-    // group channel provided data to verify in comming steps
     for (auto const& stat_item : channel_provided_statistics)
     for (auto const& file_item : stat_item.second.file_items)
-    for (auto const& count_item : file_item.count_items)
     {
         file_uris.insert(file_item.file_uri);
         unit_uris.insert(file_item.unit_uri);
-
-        string channel_id = stat_item.first;
-        string file_uri = file_item.file_uri;
-        string storage_id = count_item.peer_address;
-
-        assert(count_item.count != 0);
-        if (count_item.count == 0)
-            throw std::logic_error("count_item.count == 0");
-
-        // it is safe to assume that initial value 0 will be created
-        channel_statistics[channel_id][file_uri][storage_id] += count_item.count;
-    }
-
-    // cross compare channel and storage provided data
-    for (auto const& stat_item : storage_provided_statistics)
-    for (auto const& file_item : stat_item.second.file_items)
-    for (auto const& count_item : file_item.count_items)
-    {
-        string channel_id = count_item.peer_address;
-        string file_uri = file_item.file_uri;
-        string storage_id = stat_item.first;
-
-        // channel_statistics is not used anymore so
-        // don't care if 0 value is created below, when it dit not exist
-        uint64_t stat_value = channel_statistics[channel_id][file_uri][storage_id];
-
-        assert(count_item.count != 0);
-        if (count_item.count == 0)
-            throw std::logic_error("count_item.count == 0");
-
-        if (stat_value > 0 &&
-            false == stat_mismatch(stat_value, count_item.count))
-            cross_verified_statistics[channel_id][file_uri].insert(storage_id);
     }
 
-    // from here on - cross_verified_statistics holds values only for agreeing entries
-    // storage_provided_statistics and channel_statistics are not used
-
     auto check_file_uris = impl.m_documents.files_exist(file_uris);
     assert(check_file_uris.first);
     if (false == check_file_uris.first)
@@ -160,152 +111,29 @@ void validate_statistics(map<string, ServiceStatistics> const& channel_provided_
     if (false == check_unit_uris.first)
         throw std::logic_error("false == check_unit_uris.first");
 
-    // group views by storage
-    // sum by serving channel, unit and file
-    // storage     view
-    map<string, uint64_t> storage_group;
-
-    // group views by unit and file
-    // sum by serving channel and storage
-    // unit_uri    file_uri   view
-    map<string, map<string, uint64_t>> author_group;
-
-    // group views by serving channel, owner channel
-    // group by content id, file_uri and unit (units are limited by the particular content_id)
-    // sum by storage
-    // will take max by file and unit later then sum again by content id
-    // channel     owner       content_id   unit_uri     file_uri   view
-    map<string, map<string, map<uint64_t, map<string, map<string, uint64_t>>>>> content_group;
-
-    for (auto const& stat_item : channel_provided_statistics)
-    for (auto const& file_item : stat_item.second.file_items)
-    for (auto const& count_item : file_item.count_items)
-    {
-        string channel_id = stat_item.first;
-        string file_uri = file_item.file_uri;
-        string unit_uri = file_item.unit_uri;
-        string storage_id = count_item.peer_address;
-        uint64_t view_count = count_item.count;
-
-        // cross_verified_statistics will not be used anymore
-        // so, don't care if empty object gets created
-        bool is_cross_verified = cross_verified_statistics[channel_id][file_uri].count(storage_id);
-
-        assert(view_count > 0);
-        if (0 == view_count)
-            throw std::logic_error("0 == view_count");
-
-        if (is_cross_verified)
-        {
-            storage_group[storage_id] += view_count;
-            author_group[unit_uri][file_uri] += view_count;
-
-            ContentUnit content_unit = impl.m_documents.get_unit(unit_uri);
-            content_group[channel_id][content_unit.channel_address][content_unit.content_id][unit_uri][file_uri] += view_count;
-        }
-    }
-
-    uint64_t total_view_all_files_count = 0;
-    // collect storages final result
-    // the sum of values hold by storage_result is the total_view_units_count
-    for (auto const& item : storage_group)
+    statistics_lookup lookup;
+    lookup.get_unit = [&impl](string const& uri) -> ContentUnit const&
     {
-        total_view_all_files_count += item.second;
-        storage_result.insert({item.first, {item.second, 1}});
-    }
-
-    for (auto& item_result : storage_result)
-        item_result.second.second *= total_view_all_files_count;
-
-    uint64_t total_view_units_count = 0;
-    // collect authors final result
-    for (auto const& item_per_unit : author_group)
-    {
-        uint64_t total = 0;
-        uint64_t file_count = item_per_unit.second.size();
-        for (auto const& item_per_file : item_per_unit.second)
-            total += item_per_file.second;
-
-        assert(file_count);
-        if (0 == file_count)
-            throw std::logic_error("0 == file_count");
-
-        // get average value as a unit usage
-        total /= file_count;
-
-        total_view_units_count += total;
-
-        assert(total != 0);
-        if (0 == total)
-            throw std::logic_error("0 == total");
-
-        for (auto const& item_per_file : item_per_unit.second)
-        {
-            string const& file_uri = item_per_file.first;
-
-            File file = impl.m_documents.get_file(file_uri);
-            uint64_t authors_count = file.author_addresses.size();
-
-            for (auto const& author_address : file.author_addresses)
-                author_result.insert({author_address, {total, file_count * authors_count}});
-        }
-    }
-
-    for (auto& item_result : author_result)
-        item_result.second.second *= total_view_units_count;
-
-    uint64_t total_channel_view_count = 0;
-    // collect channels final result
-    for (auto const& item_per_server : content_group)
+        return impl.m_documents.get_unit(uri);
+    };
+    lookup.get_file = [&impl](string const& uri) -> File const&
     {
-        // item_per_server.first is the serving channel
-        string const& serving_channel = item_per_server.first;
-
-        for (auto const& item_per_owner : item_per_server.second)
-        {
-            // item_per_owner.first is the owner channel
-            string const& owner_channel = item_per_owner.first;
-
-            for (auto const& item_per_content_id : item_per_owner.second)
-            {
-                for (auto const& item_per_unit : item_per_content_id.second)
-                {
-                    auto& unit_value = map_unit_uri_view_counts[item_per_unit.first][serving_channel];
-
-                    for (auto const& item_per_file : item_per_unit.second)
-                        unit_value = std::max(unit_value, item_per_file.second);
-                }
-            }
-
-            /*uint64_t count = 0;
-            for (auto const& item_per_content_id : item_per_owner.second)
-            {
-                uint64_t max_count_per_content_id = 0;
-                for (auto const& item_per_unit : item_per_content_id.second)
-                for (auto const& item_per_file : item_per_unit.second)
-                    max_count_per_content_id = std::max(max_count_per_content_id, item_per_file.second);
-                count += max_count_per_content_id;
-            }*/
-            uint64_t count = impl.pcounts_per_channel_views(item_per_owner.second,
-                                                            block_number,
-                                                            impl.m_testnet);
-
-            if (serving_channel == owner_channel)
-            {
-                channel_result.insert({serving_channel, {2 * count, 2}});
-            }
-            else
-            {
-                channel_result.insert({owner_channel, {count, 2}});
-                channel_result.insert({serving_channel, {count, 2}});
-            }
-
-            total_channel_view_count += count;
-        }
-    }
-
-    for (auto& item_result : channel_result)
-        item_result.second.second *= total_channel_view_count;
+        return impl.m_documents.get_file(uri);
+    };
+    if (impl.pcounts_per_channel_views != &detail::counts_per_channel_views)
+        lookup.counts_per_channel_views = impl.pcounts_per_channel_views;
+    lookup.testnet = impl.m_testnet;
+    lookup.threads = std::min(size_t(STATISTICS_VALIDATION_MAX_THREADS),
+                              size_t(std::thread::hardware_concurrency()));
+
+    aggregate_statistics(channel_provided_statistics,
+                         storage_provided_statistics,
+                         lookup,
+                         block_number,
+                         author_result,
+                         channel_result,
+                         storage_result,
+                         map_unit_uri_view_counts);
 }
 
 coin distribute_rewards(vector<Reward>& rewards,
@@ -375,13 +203,14 @@ void grant_rewards(vector<SignedTransaction> const& signed_transactions,
     for (auto it = signed_transactions.begin(); it != signed_transactions.end(); ++it)
     {
         // only servicestatistics corresponding to current block will be taken
-        if (it->transaction_details.action.type() == ServiceStatistics::rtt)
+        ServiceStatistics expanded_statistics;
+        ServiceStatistics const* pservice_statistics = get_service_statistics(it->transaction_details.action, expanded_statistics);
+        if (pservice_statistics)
         {
-            ServiceStatistics const* service_statistics;
-            it->transaction_details.action.get(service_statistics);
+            ServiceStatistics const& service_statistics = *pservice_statistics;
 
             NodeType node_type;
-            if (impl.m_state.get_role(service_statistics->server_address, node_type))
+            if (impl.m_state.get_role(service_statistics.server_address, node_type))
             {
                 assert(node_type == NodeType::channel || node_type == NodeType::storage);
                 if (node_type != NodeType::channel && node_type != NodeType::storage)
@@ -394,8 +223,8 @@ void grant_rewards(vector<SignedTransaction> const& signed_transactions,
                     pstatistics = &storage_provided_statistics;
 
                 auto insert_result = pstatistics->insert({
-                                                             service_statistics->server_address,
-                                                             *service_statistics
+                                                             service_statistics.server_address,
+                                                             service_statistics
                                                          });
 
                 //  unfortunately there is already a block with double stat reports
@@ -403,12 +232,12 @@ void grant_rewards(vector<SignedTransaction> const& signed_transactions,
                 /*
                 if (false == insert_result.second)
                     throw wrong_data_exception("statistics from " +
-                                               service_statistics->server_address +
+                                               service_statistics.server_address +
                                                " are already included in the block");
                                                */
                 //  keep the last statistics report - overwrite the original value
                 if (false == insert_result.second)
-                    insert_result.first->second = *service_statistics;
+                    insert_result.first->second = service_statistics;
             }
         }
         else if (it->transaction_details.action.type() == CancelSponsorContentUnit::rtt)
@@ -432,14 +261,39 @@ void grant_rewards(vector<SignedTransaction> const& signed_transactions,
     multimap<string, pair<uint64_t, uint64_t>> channel_result;
     multimap<string, pair<uint64_t, uint64_t>> storage_result;
 
-    validate_statistics(channel_provided_statistics,
-                        storage_provided_statistics,
-                        author_result,
-                        channel_result,
-                        storage_result,
-                        unit_uri_view_counts,
-                        block_header.block_number,
-                        impl);
+    if (false == channel_provided_statistics.empty())
+    {
+        //  mining, checking a received block and reverting it all
+        //  see the same state here, validate the statistics only once
+        string cache_key = detail::statistics_cache::key(block_header, signed_transactions);
+        auto cached = impl.m_statistics_cache.find(cache_key);
+        if (cached)
+        {
+            author_result = cached->author_result;
+            channel_result = cached->channel_result;
+            storage_result = cached->storage_result;
+            unit_uri_view_counts = cached->unit_uri_view_counts;
+        }
+        else
+        {
+            validate_statistics(channel_provided_statistics,
+                                storage_provided_statistics,
+                                author_result,
+                                channel_result,
+                                storage_result,
+                                unit_uri_view_counts,
+                                block_header.block_number,
+                                impl);
+
+            detail::statistics_cache::result value;
+            value.author_result = author_result;
+            value.channel_result = channel_result;
+            value.storage_result = storage_result;
+            value.unit_uri_view_counts = unit_uri_view_counts;
+
+            impl.m_statistics_cache.insert(cache_key, value);
+        }
+    }
 
     assert(unit_uri_view_counts.empty() || (false == unit_uri_view_counts.empty() &&
                                             false == author_result.empty() &&
@@ -455,36 +309,39 @@ void grant_rewards(vector<SignedTransaction> const& signed_transactions,
 
     coin sponsored_reward = coin(0, 0);
 
+    vector<string> served_unit_uris;
     for (auto const& unit_uri : unit_uri_view_counts)
-    {
-        // sponsor       txid   amount
-        map<string, map<string, coin>> sponsored_rewards =
-        impl.m_documents.sponsored_content_unit_set_used(impl,
-                                                         unit_uri.first,
-                                                         block_header.block_number,
-                                                         rewards_type::apply == type ?
-                                                             documents::sponsored_content_unit_set_used_apply :
-                                                             documents::sponsored_content_unit_set_used_revert,
-                                                         string(),  //  transaction_hash_to_validate
-                                                         string(),  //  manual_by_account
-                                                         false);
-        for (auto const& sponsored_reward_by_sponsor : sponsored_rewards)
-        for (auto const& sponsored_reward_by_sponsor_by_txid : sponsored_reward_by_sponsor.second)
-        {
-            sponsored_reward += sponsored_reward_by_sponsor_by_txid.second;
+        served_unit_uris.push_back(unit_uri.first);
 
-            auto insert_result =
-                    applied_sponsor_items.insert({
-                                                     sponsored_reward_by_sponsor_by_txid.first, // txid
-                                                     sponsored_reward_by_sponsor_by_txid.second // coin
-                                                 });
+    auto expirings = impl.m_documents.content_unit_uri_sponsor_expiring(block_header.block_number);
 
-            if (false == insert_result.second)
-                throw std::logic_error("applied_sponsor_items.insert");
+    StorageTypes::SponsoredInformationUndo sponsored_undo;
+    if (rewards_type::apply == type)
+    {
+        //  the units changed below, served or with expiring sponsorship
+        vector<string> changed_unit_uris = served_unit_uris;
+        for (auto const& expiring_item : expirings)
+        {
+            if (0 == unit_uri_view_counts.count(expiring_item.first))
+                changed_unit_uris.push_back(expiring_item.first);
         }
+        std::sort(changed_unit_uris.begin(), changed_unit_uris.end());
+        changed_unit_uris.erase(std::unique(changed_unit_uris.begin(), changed_unit_uris.end()),
+                                changed_unit_uris.end());
+
+        sponsored_undo = impl.m_documents.sponsored_undo_begin(block_header.block_number, changed_unit_uris);
     }
 
-    auto expirings = impl.m_documents.content_unit_uri_sponsor_expiring(block_header.block_number);
+    applied_sponsor_items =
+            impl.m_documents.sponsored_content_units_set_used(impl,
+                                                              served_unit_uris,
+                                                              block_header.block_number,
+                                                              rewards_type::apply == type ?
+                                                                  documents::sponsored_content_unit_set_used_apply :
+                                                                  documents::sponsored_content_unit_set_used_revert);
+    for (auto const& applied_sponsor_item : applied_sponsor_items)
+        sponsored_reward += applied_sponsor_item.second;
+
     for (auto const& expiring_item : expirings)
     {
         auto const& expiring_item_uri = expiring_item.first;
@@ -519,6 +376,9 @@ void grant_rewards(vector<SignedTransaction> const& signed_transactions,
         }
     }
 
+    if (rewards_type::apply == type)
+        impl.m_documents.sponsored_undo_record(std::move(sponsored_undo));
+
     coin emission_reward = impl.m_block_reward_array[year_index];
 
     if (year_index < impl.m_block_reward_array.size())
@@ -630,16 +490,17 @@ bool check_service_statistics(Block const& block,
 
     for (auto it = block.signed_transactions.begin(); it != block.signed_transactions.end(); ++it)
     {
-        if (it->transaction_details.action.type() == ServiceStatistics::rtt)
+        ServiceStatistics expanded_statistics;
+        ServiceStatistics const* pservice_statistics = get_service_statistics(it->transaction_details.action, expanded_statistics);
+        if (pservice_statistics)
         {
-            ServiceStatistics const* service_statistics;
-            it->transaction_details.action.get(service_statistics);
+            ServiceStatistics const& service_statistics = *pservice_statistics;
 
-            if (service_statistics->start_time_point.tm == system_clock::to_time_t(tp_start) &&
-                service_statistics->end_time_point.tm == system_clock::to_time_t(tp_end))
+            if (service_statistics.start_time_point.tm == system_clock::to_time_t(tp_start) &&
+                service_statistics.end_time_point.tm == system_clock::to_time_t(tp_end))
             {
                 NodeType node_type;
-                if (impl.m_state.get_role(service_statistics->server_address, node_type))
+                if (impl.m_state.get_role(service_statistics.server_address, node_type))
                 {
                     if (node_type == NodeType::channel)
                         ++block_channel_stat_count;
@@ -652,16 +513,17 @@ bool check_service_statistics(Block const& block,
 
     for (auto it = pool_transactions.begin(); it != pool_transactions.end(); ++it)
     {
-        if (it->transaction_details.action.type() == ServiceStatistics::rtt)
+        ServiceStatistics expanded_statistics;
+        ServiceStatistics const* pservice_statistics = get_service_statistics(it->transaction_details.action, expanded_statistics);
+        if (pservice_statistics)
         {
-            ServiceStatistics const* service_statistics;
-            it->transaction_details.action.get(service_statistics);
+            ServiceStatistics const& service_statistics = *pservice_statistics;
 
-            if (service_statistics->start_time_point.tm == system_clock::to_time_t(tp_start) &&
-                service_statistics->end_time_point.tm == system_clock::to_time_t(tp_end))
+            if (service_statistics.start_time_point.tm == system_clock::to_time_t(tp_start) &&
+                service_statistics.end_time_point.tm == system_clock::to_time_t(tp_end))
             {
                 NodeType node_type;
-                if (impl.m_state.get_role(service_statistics->server_address, node_type))
+                if (impl.m_state.get_role(service_statistics.server_address, node_type))
                 {
                     if (node_type == NodeType::channel)
                         ++known_channel_stat_count;
@@ -674,16 +536,17 @@ bool check_service_statistics(Block const& block,
 
     for (auto it = reverted_transactions.begin(); it != reverted_transactions.end(); ++it)
     {
-        if (it->transaction_details.action.type() == ServiceStatistics::rtt)
+        ServiceStatistics expanded_statistics;
+        ServiceStatistics const* pservice_statistics = get_service_statistics(it->transaction_details.action, expanded_statistics);
+        if (pservice_statistics)
         {
-            ServiceStatistics const* service_statistics;
-            it->transaction_details.action.get(service_statistics);
+            ServiceStatistics const& service_statistics = *pservice_statistics;
 
-            if (service_statistics->start_time_point.tm == system_clock::to_time_t(tp_start) &&
-                service_statistics->end_time_point.tm == system_clock::to_time_t(tp_end))
+            if (service_statistics.start_time_point.tm == system_clock::to_time_t(tp_start) &&
+                service_statistics.end_time_point.tm == system_clock::to_time_t(tp_end))
             {
                 NodeType node_type;
-                if (impl.m_state.get_role(service_statistics->server_address, node_type))
+                if (impl.m_state.get_role(service_statistics.server_address, node_type))
                 {
                     if (node_type == NodeType::channel)
                         ++known_channel_stat_count;
@@ -828,40 +691,19 @@ void mine_block(publiqpp::detail::node_internals& impl)
 
     uint64_t block_number = impl.m_blockchain.length() - 1;
 
-    //  calculate consensus_const
-    vector<pair<uint64_t, uint64_t>> delta_vector;
-    size_t block_index = 0;
-    if (block_number + 1 >= DELTA_STEP)
-        block_index = block_number + 1 - DELTA_STEP;
-    for (; block_index <= block_number; ++block_index)
-    {
-        BlockHeader const& tmp_header = impl.m_blockchain.header_at(block_index);
-        delta_vector.push_back(std::make_pair(tmp_header.delta, tmp_header.c_const));
-    }
-
-    assert(false == delta_vector.empty());
+    detail::consensus_delta const& consensus = impl.consensus();
 
-    string check_delta_vector_error;
-    uint64_t calculate_c_const = check_delta_vector(delta_vector, check_delta_vector_error);
-    assert(check_delta_vector_error.empty());
-    if (false == check_delta_vector_error.empty())
-        throw std::logic_error("own blockchain is somehow wrong");
-
-    SignedBlock const& prev_signed_block = impl.m_blockchain.at(block_number);
     BlockHeader const& prev_header = impl.m_blockchain.last_header();
     string own_key = impl.m_pb_key.to_string();
-    string prev_hash = meshpp::hash(prev_signed_block.block_details.to_string());
+    string prev_hash = consensus.head_hash;
 
-    uint64_t delta = impl.calc_delta(own_key,
-                                     impl.get_balance().whole,
-                                     prev_hash,
-                                     prev_header.c_const);
+    uint64_t delta = impl.own_delta();
 
     // fill new block header data
     BlockHeader block_header;
     block_header.block_number = block_number + 1;
     block_header.delta = delta;
-    block_header.c_const = calculate_c_const;
+    block_header.c_const = consensus.c_const;
     block_header.c_sum = prev_header.c_sum + delta;
     block_header.prev_hash = prev_hash;
     block_header.time_signed.tm = prev_header.time_signed.tm + BLOCK_MINE_DELAY;
@@ -904,16 +746,17 @@ void mine_block(publiqpp::detail::node_internals& impl)
                             &channel_statistics,
                             &storage_statistics](SignedTransaction& signed_tr)
     {
-        if (signed_tr.transaction_details.action.type() == ServiceStatistics::rtt)
+        ServiceStatistics expanded_statistics;
+        ServiceStatistics const* pservice_statistics = get_service_statistics(signed_tr.transaction_details.action, expanded_statistics);
+        if (pservice_statistics)
         {
-            ServiceStatistics* service_statistics;
-            signed_tr.transaction_details.action.get(service_statistics);
+            ServiceStatistics const& service_statistics = *pservice_statistics;
 
-            if (service_statistics->start_time_point.tm == system_clock::to_time_t(tp_start) &&
-                service_statistics->end_time_point.tm == system_clock::to_time_t(tp_end))
+            if (service_statistics.start_time_point.tm == system_clock::to_time_t(tp_start) &&
+                service_statistics.end_time_point.tm == system_clock::to_time_t(tp_end))
             {
                 NodeType node_type;
-                if (impl.m_state.get_role(service_statistics->server_address, node_type))
+                if (impl.m_state.get_role(service_statistics.server_address, node_type))
                 {
                     if (node_type == NodeType::channel)
                         channel_statistics.push_back(std::move(signed_tr));
@@ -1119,13 +962,14 @@ void mine_block(publiqpp::detail::node_internals& impl)
     {
         auto& signed_transaction = reverted_transactions_ex[index].stx;
         bool can_put_in_block = true;
-        if (signed_transaction.transaction_details.action.type() == ServiceStatistics::rtt)
+        ServiceStatistics expanded_statistics;
+        ServiceStatistics const* pservice_statistics = get_service_statistics(signed_transaction.transaction_details.action, expanded_statistics);
+        if (pservice_statistics)
         {
-            ServiceStatistics* paction;
-            signed_transaction.transaction_details.action.get(paction);
+            ServiceStatistics const& service_statistics = *pservice_statistics;
 
-            if (paction->start_time_point.tm != system_clock::to_time_t(tp_start) ||
-                paction->end_time_point.tm != system_clock::to_time_t(tp_end))
+            if (service_statistics.start_time_point.tm != system_clock::to_time_t(tp_start) ||
+                service_statistics.end_time_point.tm != system_clock::to_time_t(tp_end))
                 can_put_in_block = false;
         }
         if (block_transactions.size() < size_t(BLOCK_MAX_TRANSACTIONS) && can_put_in_block)
@@ -1278,19 +1122,7 @@ void broadcast_node_type(std::unique_ptr<publiqpp::detail::node_internals>& m_pi
     signed_transaction.transaction_details = transaction;
 
     if (action_process_on_chain(signed_transaction, *m_pimpl.get()))
-    {
-        Broadcast broadcast;
-        broadcast.echoes = 2;
-        broadcast.package = signed_transaction;
-
-        broadcast_message(std::move(broadcast),
-                          m_pimpl->m_ptr_p2p_socket->name(),
-                          m_pimpl->m_ptr_p2p_socket->name(),
-                          true, // broadcast to all peers
-                          nullptr, // log disabled
-                          m_pimpl->m_p2p_peers,
-                          m_pimpl->m_ptr_p2p_socket.get());
-    }
+        m_pimpl->m_transaction_inventory.announce(signed_transaction);
 }
 
 void broadcast_address_info(std::unique_ptr<publiqpp::detail::node_internals>& m_pimpl)
@@ -1330,7 +1162,7 @@ void broadcast_address_info(std::unique_ptr<publiqpp::detail::node_internals>& m
         true, // broadcast to all peers
         nullptr, // log disabled
         m_pimpl->m_p2p_peers,
-        m_pimpl->m_ptr_p2p_socket.get());
+        m_pimpl->m_p2p_send_queue);
 }
 
 bool process_address_info(BlockchainMessage::SignedTransaction const& signed_transaction,
@@ -1399,7 +1231,10 @@ void broadcast_service_statistics(publiqpp::detail::node_internals& impl)
     service_statistics.end_time_point.tm = system_clock::to_time_t(tp_end);
 
     Transaction transaction;
-    transaction.action = std::move(service_statistics);
+    if (compact_statistics_active(impl))
+        transaction.action = compress_statistics(service_statistics);
+    else
+        transaction.action = std::move(service_statistics);
     transaction.creation.tm = system_clock::to_time_t(system_clock::now());
     transaction.expiry.tm = system_clock::to_time_t(system_clock::now() + chrono::seconds(2 * BLOCK_MINE_DELAY));
     impl.m_fee_transactions.to_Coin(transaction.fee);
@@ -1413,19 +1248,7 @@ void broadcast_service_statistics(publiqpp::detail::node_internals& impl)
     signed_transaction.transaction_details = transaction;
 
     if (action_process_on_chain(signed_transaction, impl))
-    {
-        Broadcast broadcast;
-        broadcast.echoes = 2;
-        broadcast.package = signed_transaction;
-
-        broadcast_message(std::move(broadcast),
-            impl.m_ptr_p2p_socket->name(),
-            impl.m_ptr_p2p_socket->name(),
-            true, // broadcast to all peers
-            nullptr, // log disabled
-            impl.m_p2p_peers,
-            impl.m_ptr_p2p_socket.get());
-    }
+        impl.m_transaction_inventory.announce(signed_transaction);
 }
 
 
@@ -1453,18 +1276,81 @@ void broadcast_storage_update(publiqpp::detail::node_internals& impl,
     signed_transaction.transaction_details = transaction;
 
     if (action_process_on_chain(signed_transaction, impl))
+        impl.m_transaction_inventory.announce(signed_transaction);
+}
+
+void announce_transactions(publiqpp::detail::node_internals& impl)
+{
+    //  congested peers will hear about these with the next pool announce
+    unordered_set<beltpp::isocket::peer_id> peers;
+    for (auto const& peerid : impl.m_p2p_peers)
+    {
+        if (false == impl.m_p2p_send_queue.congested(peerid))
+            peers.insert(peerid);
+    }
+
+    unordered_map<beltpp::isocket::peer_id, vector<string>> broadcasts;
+    auto announcements = impl.m_transaction_inventory.take_announcements(peers, broadcasts);
+
+    for (auto& announcement : announcements)
+    {
+        auto& keys = announcement.second;
+
+        for (size_t index = 0; index < keys.size(); index += TRANSACTION_INVENTORY_MAX_LENGTH)
+        {
+            auto it_end = keys.size() - index > TRANSACTION_INVENTORY_MAX_LENGTH ?
+                              keys.begin() + index + TRANSACTION_INVENTORY_MAX_LENGTH :
+                              keys.end();
+
+            TransactionInventory transaction_inventory;
+            transaction_inventory.transaction_hashes.assign(keys.begin() + index, it_end);
+
+            impl.m_p2p_send_queue.send(announcement.first,
+                                       beltpp::packet(std::move(transaction_inventory)),
+                                       send_queue::transactions);
+        }
+    }
+
+    //  peers running before the inventory get the full broadcast as they used to
+    for (auto const& broadcast_item : broadcasts)
     {
-        Broadcast broadcast;
-        broadcast.echoes = 2;
-        broadcast.package = signed_transaction;
-
-        broadcast_message(std::move(broadcast),
-            impl.m_ptr_p2p_socket->name(),
-            impl.m_ptr_p2p_socket->name(),
-            true, // broadcast to all peers
-            nullptr, // log disabled
-            impl.m_p2p_peers,
-            impl.m_ptr_p2p_socket.get());
+        for (auto const& key : broadcast_item.second)
+        {
+            SignedTransaction const* p_signed_transaction = impl.m_transaction_inventory.find(key);
+            if (nullptr == p_signed_transaction)
+                continue;
+
+            Broadcast broadcast;
+            broadcast.echoes = 2;
+            broadcast.package = *p_signed_transaction;
+
+            impl.m_p2p_send_queue.send(broadcast_item.first,
+                                       beltpp::packet(std::move(broadcast)),
+                                       send_queue::transactions);
+        }
+    }
+
+    //  ask the next announcer for what the previous one did not deliver
+    auto retries = impl.m_transaction_inventory.take_retries();
+    for (auto& retry : retries)
+    {
+        if (0 == impl.m_p2p_peers.count(retry.first))
+            continue;
+
+        auto& keys = retry.second;
+        for (size_t index = 0; index < keys.size(); index += TRANSACTION_INVENTORY_MAX_LENGTH)
+        {
+            auto it_end = keys.size() - index > TRANSACTION_INVENTORY_MAX_LENGTH ?
+                              keys.begin() + index + TRANSACTION_INVENTORY_MAX_LENGTH :
+                              keys.end();
+
+            TransactionInventoryRequest inventory_request;
+            inventory_request.transaction_hashes.assign(keys.begin() + index, it_end);
+
+            impl.m_p2p_send_queue.send(retry.first,
+                                       beltpp::packet(std::move(inventory_request)),
+                                       send_queue::transactions);
+        }
     }
 }
 }// end of namespace publiqpp
@@ -23,6 +23,8 @@ void broadcast_storage_update(publiqpp::detail::node_internals& impl,
                               std::string const& uri,
                               BlockchainMessage::UpdateType const& status);
 
+void announce_transactions(publiqpp::detail::node_internals& impl);
+
 bool apply_transaction(BlockchainMessage::SignedTransaction const& signed_transaction,
                        publiqpp::detail::node_internals& impl,
                        std::string const& key = std::string());
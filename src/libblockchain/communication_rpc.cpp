@@ -190,7 +190,7 @@ void broadcast_message(BlockchainMessage::Broadcast&& broadcast,
                        bool full_broadcast,
                        beltpp::ilog* plog,
                        std::unordered_set<beltpp::isocket::peer_id> const& all_peers,
-                       beltpp::isocket* psk)
+                       send_queue& p2p_send_queue)
 {
     auto str_compare = [](string const& first, string const& second)
     {
@@ -264,7 +264,7 @@ void broadcast_message(BlockchainMessage::Broadcast&& broadcast,
         if (plog)
             plog->message("will rebroadcast to: " + peer);
 
-        psk->send(peer, beltpp::packet(broadcast));
+        p2p_send_queue.send(peer, beltpp::packet(broadcast), send_queue::transactions);
     }
 }
 
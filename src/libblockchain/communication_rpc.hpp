@@ -43,6 +43,6 @@ void broadcast_message(BlockchainMessage::Broadcast&& broadcast,
                        bool full_broadcast,
                        beltpp::ilog* plog,
                        std::unordered_set<beltpp::isocket::peer_id> const& all_peers,
-                       beltpp::isocket* psk);
+                       send_queue& p2p_send_queue);
 
 }// end of namespace publiqpp
@@ -49,6 +49,7 @@ public:
         , m_content_unit_sponsored_information("content_unit_info", path_documents, 10000, get_putl_types())
         , m_sponsored_informations_expiring("sponsored_info_expiring", path_documents, 10000, get_putl_types())
         , m_sponsored_informations_hash_to_block("sponsored_info_hash_to_block", path_documents, 10000, get_putl_types())
+        , m_sponsored_undo("sponsored_undo", path_documents, 10000, get_putl_types())
     {}
 
     meshpp::map_loader<File> m_files;
@@ -57,6 +58,7 @@ public:
     meshpp::map_loader<StorageTypes::ContentUnitSponsoredInformation> m_content_unit_sponsored_information;
     meshpp::map_loader<StorageTypes::SponsoredInformationHeaders> m_sponsored_informations_expiring;
     meshpp::map_loader<StorageTypes::TransactionHashToBlockNumber> m_sponsored_informations_hash_to_block;
+    meshpp::map_loader<StorageTypes::SponsoredInformationUndo> m_sponsored_undo;
 };
 }
 
@@ -77,6 +79,7 @@ void documents::save()
     m_pimpl->m_content_unit_sponsored_information.save();
     m_pimpl->m_sponsored_informations_expiring.save();
     m_pimpl->m_sponsored_informations_hash_to_block.save();
+    m_pimpl->m_sponsored_undo.save();
 }
 
 void documents::commit() noexcept
@@ -89,6 +92,7 @@ void documents::commit() noexcept
     m_pimpl->m_content_unit_sponsored_information.commit();
     m_pimpl->m_sponsored_informations_expiring.commit();
     m_pimpl->m_sponsored_informations_hash_to_block.commit();
+    m_pimpl->m_sponsored_undo.commit();
 }
 
 void documents::discard() noexcept
@@ -101,6 +105,7 @@ void documents::discard() noexcept
     m_pimpl->m_content_unit_sponsored_information.discard();
     m_pimpl->m_sponsored_informations_expiring.discard();
     m_pimpl->m_sponsored_informations_hash_to_block.discard();
+    m_pimpl->m_sponsored_undo.discard();
 }
 
 void documents::clear()
@@ -113,6 +118,7 @@ void documents::clear()
     m_pimpl->m_content_unit_sponsored_information.clear();
     m_pimpl->m_sponsored_informations_expiring.clear();
     m_pimpl->m_sponsored_informations_hash_to_block.clear();
+    m_pimpl->m_sponsored_undo.clear();
 }
 
 pair<bool, string> documents::files_exist(unordered_set<string> const& uris) const
@@ -296,6 +302,59 @@ void refresh_index(StorageTypes::ContentUnitSponsoredInformation& cusi)
         cusi.index_si.push_back(arr_index_item.first);
 }
 
+time_point sponsored_time_point(publiqpp::detail::node_internals const& impl,
+                                size_t block_number)
+{
+    auto block_header = impl.m_blockchain.last_header();
+    time_point tp = system_clock::from_time_t(block_header.time_signed.tm);
+    if (block_number > block_header.block_number)
+        tp += chrono::seconds(BLOCK_MINE_DELAY * (block_number - block_header.block_number));
+
+    assert(block_number == block_header.block_number ||
+           block_number == block_header.block_number + 1);
+    if (block_number != block_header.block_number &&
+        block_number != block_header.block_number + 1)
+        throw std::logic_error("block_number range");
+
+    return chrono::time_point_cast<chrono::seconds>(tp);
+}
+
+//  the part of the sponsored amount used between start_tp and end_tp
+coin sponsored_part(StorageTypes::SponsoredInformation const& item,
+                    size_t time_points_used_size,
+                    time_point const& start_tp,
+                    time_point const& end_tp,
+                    bool to_item_end)
+{
+    auto item_start_tp = system_clock::from_time_t(item.start_time_point.tm);
+    auto item_end_tp = system_clock::from_time_t(item.end_time_point.tm);
+
+    coin whole = item.amount;
+    auto whole_duration = item_end_tp - item_start_tp;
+
+    auto part_start_tp = std::max(start_tp, item_start_tp);
+    auto part_end_tp = std::min(end_tp, item_end_tp);
+
+    if (to_item_end)
+        part_end_tp = item_end_tp;
+    if (item.time_points_used_before == time_points_used_size)
+        part_start_tp = item_start_tp;
+
+    auto part_duration = part_end_tp - part_start_tp;
+
+    coin part = whole / uint64_t(chrono::duration_cast<chrono::seconds>(whole_duration).count())
+                      * uint64_t(chrono::duration_cast<chrono::seconds>(part_duration).count());
+
+    if (part_end_tp == item_end_tp)
+        part += whole % uint64_t(chrono::duration_cast<chrono::seconds>(whole_duration).count());
+
+    assert(part != coin());
+    if (part == coin())
+        throw std::logic_error("part == coin()");
+
+    return part;
+}
+
 size_t get_expiring_block_number(publiqpp::detail::node_internals const& impl,
                                  chrono::system_clock::time_point const& item_end_tp)
 {
@@ -499,16 +558,7 @@ map<string, map<string, coin>> documents::sponsored_content_unit_set_used(publiq
 
     bool manual = (false == manual_by_account.empty());
 
-    auto block_header = impl.m_blockchain.last_header();
-    time_point tp = system_clock::from_time_t(block_header.time_signed.tm);
-    if (block_number > block_header.block_number)
-        tp += chrono::seconds(BLOCK_MINE_DELAY * (block_number - block_header.block_number));
-
-    assert(block_number == block_header.block_number ||
-           block_number == block_header.block_number + 1);
-    if (block_number != block_header.block_number &&
-        block_number != block_header.block_number + 1)
-        throw std::logic_error("block_number range");
+    time_point end_tp = sponsored_time_point(impl, block_number);
 
     if (m_pimpl->m_content_unit_sponsored_information.contains(content_unit_uri))
     {
@@ -523,8 +573,6 @@ map<string, map<string, coin>> documents::sponsored_content_unit_set_used(publiq
         if (cusi.time_points_used.empty())
             throw std::logic_error("cusi.time_points_used.empty()");
 
-        auto end_tp = tp;
-        end_tp = chrono::time_point_cast<chrono::seconds>(end_tp);
         auto start_tp = system_clock::from_time_t(cusi.time_points_used.back().tm);
 
         if ((sponsored_content_unit_set_used_apply == type && end_tp > start_tp) ||
@@ -559,7 +607,6 @@ map<string, map<string, coin>> documents::sponsored_content_unit_set_used(publiq
                 auto& item = cusi.sponsored_informations[index_si_item];
 
                 auto item_start_tp = system_clock::from_time_t(item.start_time_point.tm);
-                auto item_end_tp = system_clock::from_time_t(item.end_time_point.tm);
 
                 if (item_start_tp >= end_tp)
                     break;
@@ -571,28 +618,11 @@ map<string, map<string, coin>> documents::sponsored_content_unit_set_used(publiq
                     item.transaction_hash != transaction_hash_to_cancel)
                     continue;   //  regardless if doing apply or revert - same
 
-                coin whole = item.amount;
-                auto whole_duration = item_end_tp - item_start_tp;
-
-                auto part_start_tp = std::max(start_tp, item_start_tp);
-                auto part_end_tp = std::min(end_tp, item_end_tp);
-
-                if (false == transaction_hash_to_cancel.empty())
-                    part_end_tp = item_end_tp;
-                if (item.time_points_used_before == cusi.time_points_used.size())
-                    part_start_tp = item_start_tp;
-
-                auto part_duration = part_end_tp - part_start_tp;
-
-                coin part = whole / uint64_t(chrono::duration_cast<chrono::seconds>(whole_duration).count())
-                                  * uint64_t(chrono::duration_cast<chrono::seconds>(part_duration).count());
-
-                if (part_end_tp == item_end_tp)
-                    part += whole % uint64_t(chrono::duration_cast<chrono::seconds>(whole_duration).count());
-
-                assert(part != coin());
-                if (part == coin())
-                    throw std::logic_error("part == coin()");
+                coin part = sponsored_part(item,
+                                           cusi.time_points_used.size(),
+                                           start_tp,
+                                           end_tp,
+                                           false == transaction_hash_to_cancel.empty());
 
                 auto& temp_result = result[item.sponsor_address];
 
@@ -682,6 +712,198 @@ map<string, map<string, coin>> documents::sponsored_content_unit_set_used(publiq
     return result;
 }
 
+map<string, coin> documents::sponsored_content_units_set_used(publiqpp::detail::node_internals const& impl,
+                                                              vector<string> const& content_unit_uris,
+                                                              size_t block_number,
+                                                              documents::e_sponsored_content_unit_set_used type)
+{
+    //  txid   amount
+    map<string, coin> result;
+
+    time_point end_tp = sponsored_time_point(impl, block_number);
+
+    for (auto const& content_unit_uri : content_unit_uris)
+    {
+        if (false == m_pimpl->m_content_unit_sponsored_information.contains(content_unit_uri))
+            continue;
+
+        StorageTypes::ContentUnitSponsoredInformation& cusi =
+                m_pimpl->m_content_unit_sponsored_information.at(content_unit_uri);
+
+        assert(false == cusi.sponsored_informations.empty());
+        assert(false == cusi.time_points_used.empty());
+
+        if (cusi.sponsored_informations.empty())
+            throw std::logic_error("cusi.sponsored_informations.empty()");
+        if (cusi.time_points_used.empty())
+            throw std::logic_error("cusi.time_points_used.empty()");
+
+        auto start_tp = system_clock::from_time_t(cusi.time_points_used.back().tm);
+
+        //  apply always records the time point, revert only undoes a matching one
+        if (sponsored_content_unit_set_used_revert == type &&
+            end_tp != start_tp)
+            continue;
+
+        if (sponsored_content_unit_set_used_revert == type)
+        {
+            cusi.time_points_used.pop_back();
+            assert(false == cusi.time_points_used.empty());
+            if (cusi.time_points_used.empty())
+                throw std::logic_error("cusi.time_points_used.empty()");
+            start_tp = system_clock::from_time_t(cusi.time_points_used.back().tm);
+
+            //  the index will be sorted below inside refresh index
+            cusi.index_si.clear();
+            for (size_t index = 0; index < cusi.sponsored_informations.size(); ++index)
+                cusi.index_si.push_back(index);
+
+            refresh_index(cusi);
+        }
+
+        if (sponsored_content_unit_set_used_revert == type ||
+            end_tp > start_tp)
+        {
+            for (auto const& index_si_item : cusi.index_si)
+            {
+                auto const& item = cusi.sponsored_informations[index_si_item];
+
+                if (system_clock::from_time_t(item.start_time_point.tm) >= end_tp)
+                    break;
+
+                if (item.cancelled)
+                    continue;
+
+                coin part = sponsored_part(item,
+                                           cusi.time_points_used.size(),
+                                           start_tp,
+                                           end_tp,
+                                           false);
+
+                auto insert_result = result.insert({item.transaction_hash, part});
+                if (false == insert_result.second)
+                    throw std::logic_error("result.insert({item.transaction_hash, part})");
+            }
+        }
+
+        if (sponsored_content_unit_set_used_apply == type)
+        {
+            StorageTypes::ctime ct;
+            ct.tm = system_clock::to_time_t(end_tp);
+            cusi.time_points_used.push_back(ct);
+
+            refresh_index(cusi);
+        }
+    }
+
+    return result;
+}
+
+StorageTypes::SponsoredInformationUndo
+documents::sponsored_undo_begin(uint64_t block_number,
+                                vector<string> const& content_unit_uris) const
+{
+    StorageTypes::SponsoredInformationUndo undo;
+    undo.block_number = block_number;
+
+    for (auto const& content_unit_uri : content_unit_uris)
+    {
+        if (false == m_pimpl->m_content_unit_sponsored_information.contains(content_unit_uri))
+            continue;
+
+        StorageTypes::ContentUnitSponsoredInformation const& cusi =
+                m_pimpl->m_content_unit_sponsored_information.as_const().at(content_unit_uri);
+
+        StorageTypes::SponsoredUsageUndo usage;
+        usage.uri = content_unit_uri;
+        usage.time_points_used_count = cusi.time_points_used.size();
+        //  until recorded, the ones expiry could still cancel
+        for (auto index : cusi.index_si)
+        {
+            if (index < cusi.sponsored_informations.size() &&
+                false == cusi.sponsored_informations[index].cancelled)
+                usage.cancelled.push_back(index);
+        }
+
+        undo.content_units.push_back(std::move(usage));
+    }
+
+    return undo;
+}
+
+void documents::sponsored_undo_record(StorageTypes::SponsoredInformationUndo&& undo)
+{
+    for (auto& usage : undo.content_units)
+    {
+        StorageTypes::ContentUnitSponsoredInformation const& cusi =
+                m_pimpl->m_content_unit_sponsored_information.as_const().at(usage.uri);
+
+        auto it_end = std::remove_if(usage.cancelled.begin(), usage.cancelled.end(),
+                                     [&cusi](uint64_t index)
+        {
+            return false == cusi.sponsored_informations[index].cancelled;
+        });
+        usage.cancelled.erase(it_end, usage.cancelled.end());
+    }
+
+    uint64_t block_number = undo.block_number;
+    string key = std::to_string(block_number);
+    if (m_pimpl->m_sponsored_undo.contains(key))
+        m_pimpl->m_sponsored_undo.at(key) = std::move(undo);
+    else
+        m_pimpl->m_sponsored_undo.insert(key, std::move(undo));
+
+    if (block_number >= SPONSORED_UNDO_MAX_BLOCKS)
+    {
+        string old_key = std::to_string(block_number - SPONSORED_UNDO_MAX_BLOCKS);
+        if (m_pimpl->m_sponsored_undo.contains(old_key))
+            m_pimpl->m_sponsored_undo.erase(old_key);
+    }
+}
+
+bool documents::sponsored_undo_replay(uint64_t block_number)
+{
+    string key = std::to_string(block_number);
+    if (false == m_pimpl->m_sponsored_undo.contains(key))
+        return false;
+
+    StorageTypes::SponsoredInformationUndo const& undo = m_pimpl->m_sponsored_undo.as_const().at(key);
+    for (auto const& usage : undo.content_units)
+    {
+        StorageTypes::ContentUnitSponsoredInformation& cusi =
+                m_pimpl->m_content_unit_sponsored_information.at(usage.uri);
+
+        for (auto index : usage.cancelled)
+        {
+            if (index >= cusi.sponsored_informations.size() ||
+                false == cusi.sponsored_informations[index].cancelled)
+                throw std::logic_error("sponsored undo: not cancelled");
+
+            cusi.sponsored_informations[index].cancelled = false;
+        }
+
+        if (cusi.time_points_used.size() < usage.time_points_used_count ||
+            cusi.time_points_used.size() > usage.time_points_used_count + 1)
+            throw std::logic_error("sponsored undo: time points used mismatch");
+
+        if (cusi.time_points_used.size() != usage.time_points_used_count)
+        {
+            cusi.time_points_used.pop_back();
+
+            //  the same as reverting the time point through set used
+            cusi.index_si.clear();
+            for (size_t index = 0; index < cusi.sponsored_informations.size(); ++index)
+                cusi.index_si.push_back(index);
+
+            refresh_index(cusi);
+        }
+    }
+
+    m_pimpl->m_sponsored_undo.erase(key);
+
+    return true;
+}
+
 vector<pair<string, string>> documents::content_unit_uri_sponsor_expiring(size_t block_number) const
 {
     vector<pair<string, string>> result;
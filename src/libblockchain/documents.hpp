@@ -15,6 +15,7 @@ namespace StorageTypes
 {
     class SponsoredInformationHeaders;
     class SponsoredInformationHeader;
+    class SponsoredInformationUndo;
 }
 namespace publiqpp
 {
@@ -76,6 +77,24 @@ public:
                                     std::string const& manual_by_account,
                                     bool pretend);
 
+    //  the plain (not cancelling) set used for all units served in a block,
+    //  result is txid to amount
+    std::map<std::string, coin>
+    sponsored_content_units_set_used(publiqpp::detail::node_internals const& impl,
+                                     std::vector<std::string> const& content_unit_uris,
+                                     size_t block_number,
+                                     e_sponsored_content_unit_set_used type);
+
+    //  keeps what a block's rewards change in the sponsored usage, so that
+    //  reverting the block restores it instead of recomputing
+    //  begin is taken before the change, record keeps only the difference
+    StorageTypes::SponsoredInformationUndo
+    sponsored_undo_begin(uint64_t block_number,
+                         std::vector<std::string> const& content_unit_uris) const;
+    void sponsored_undo_record(StorageTypes::SponsoredInformationUndo&& undo);
+    //  false if there is no record, for blocks older than the kept ones
+    bool sponsored_undo_replay(uint64_t block_number);
+
     std::vector<std::pair<std::string, std::string>>
     content_unit_uri_sponsor_expiring(size_t block_number) const;
 
@@ -43,6 +43,9 @@ namespace publiqpp
 {
 //  free functions
 void sync_worker(detail::node_internals& impl);
+void storage_gc_worker(detail::node_internals& impl);
+void process_wait_result(unique_ptr<detail::node_internals>& m_pimpl,
+                         detail::wait_result_item& wait_result);
 /*
  * node
  */
@@ -134,8 +137,311 @@ void node::run(bool& stop_check)
         broadcast_service_statistics(*m_pimpl);
     }
 
-    auto wait_result = m_pimpl->wait_and_receive_one();
+    //  all packets ready by now go before the bookkeeping below,
+    //  the ones left after an exception are processed on the next run
+    if (m_pimpl->m_wait_results.empty())
+        m_pimpl->m_wait_results = m_pimpl->wait_and_receive();
 
+    while (false == m_pimpl->m_wait_results.empty())
+    {
+        auto wait_result = std::move(m_pimpl->m_wait_results.front());
+        m_pimpl->m_wait_results.pop_front();
+
+        process_wait_result(m_pimpl, wait_result);
+    }
+
+    m_pimpl->m_sessions.erase_all_pending();
+    m_pimpl->m_sync_sessions.erase_all_pending();
+    m_pimpl->m_nodeid_sessions.erase_all_pending();
+
+    // broadcast own transactions to all peers for the case
+    // when node could not do this when received it through rpc
+    if (m_pimpl->m_broadcast_timer.expired() && !m_pimpl->m_p2p_peers.empty())
+    {
+        m_pimpl->m_broadcast_timer.update();
+
+        size_t pool_size = m_pimpl->m_transaction_pool.length();
+        if (pool_size > 0 && m_pimpl->blockchain_updated())
+        {
+            //m_pimpl->writeln_node("broadcasting old stored transactions to all peers");
+
+            auto current_time = system_clock::now();
+
+            for (size_t pool_index = 0; pool_index != pool_size; ++pool_index)
+            {
+                SignedTransaction const& signed_transaction = m_pimpl->m_transaction_pool.at(pool_index);
+
+                //  peers that have the transaction will not hear about it again,
+                //  the ones told before are told once more, their request may have failed
+                if (current_time < system_clock::from_time_t(signed_transaction.transaction_details.expiry.tm) &&
+                    current_time > system_clock::from_time_t(signed_transaction.transaction_details.creation.tm) + chrono::seconds(BLOCK_MINE_DELAY))
+                    m_pimpl->m_transaction_inventory.announce(signed_transaction, true);
+            }
+        }
+    }
+
+    // tell peers about the transactions gathered during this cycle
+    announce_transactions(*m_pimpl.get());
+
+    // blocks served meanwhile by the block server,
+    // it drops the ones of the removed peers
+    for (auto& response : m_pimpl->m_block_server.take_responses())
+        m_pimpl->m_p2p_send_queue.send(response.first,
+                                       beltpp::packet(std::move(response.second)),
+                                       send_queue::blocks);
+    for (auto const& error : m_pimpl->m_block_server.take_errors())
+        m_pimpl->writeln_node(error);
+    m_pimpl->m_p2p_send_queue.flush();
+
+    // clean old transaction keys from cache
+    // to minimize it and make it work faster
+    if (m_pimpl->m_cache_cleanup_timer.expired())
+    {
+        m_pimpl->m_cache_cleanup_timer.update();
+
+        m_pimpl->clean_transaction_cache();
+        m_pimpl->m_transaction_inventory.clean();
+
+        //  temp place
+        m_pimpl->m_nodeid_service.take_actions([this](std::string const& node_address,
+                                                      beltpp::ip_address const& address,
+                                                      std::unique_ptr<session_action_broadcast_address_info>&& ptr_action)
+        {
+            vector<unique_ptr<meshpp::session_action<meshpp::nodeid_session_header>>> actions;
+            actions.emplace_back(new session_action_connections(*m_pimpl->m_ptr_rpc_socket.get()));
+            actions.emplace_back(new session_action_signatures(*m_pimpl->m_ptr_rpc_socket.get(),
+                                                                m_pimpl->m_nodeid_service));
+
+            actions.emplace_back(std::move(ptr_action));
+
+            meshpp::nodeid_session_header header;
+            header.nodeid = node_address;
+            header.address = address;
+            m_pimpl->m_nodeid_sessions.add(header,
+                                           std::move(actions),
+                                           chrono::minutes(1));
+        });
+
+        // collect verified channel addresses and send to slave node
+        if (m_pimpl->m_node_type == NodeType::storage &&
+            m_pimpl->m_slave_node)
+        {
+            StorageTypes::SetVerifiedChannels set_channels;
+
+            PublicAddressesInfo public_addresses = m_pimpl->m_nodeid_service.get_addresses();
+            for (auto const& item : public_addresses.addresses_info)
+            {
+                if (item.seconds_since_checked > 2 * PUBLIC_ADDRESS_FRESH_THRESHHOLD_SECONDS)
+                    break;
+
+                NodeType check_role;
+                if (m_pimpl->m_state.get_role(item.node_address, check_role) &&
+                    check_role == NodeType::channel)
+                {
+                    set_channels.channel_addresses.push_back(item.node_address);
+                }
+            }
+
+            m_pimpl->m_slave_node->send(beltpp::packet(std::move(set_channels)));
+            m_pimpl->m_slave_node->wake();
+        }
+
+        //  yes temp place still
+        broadcast_node_type(m_pimpl);
+        broadcast_address_info(m_pimpl);
+    }
+
+    // init sync process and block mining
+    if (m_pimpl->m_check_timer.expired())
+    {
+        m_pimpl->m_check_timer.update();
+
+        if (m_pimpl->m_blockchain.length() < m_pimpl->m_freeze_before_block)
+            sync_worker(*m_pimpl.get());
+
+        if (m_pimpl->m_storage_sync_delay.expired() &&
+            m_pimpl->blockchain_updated() &&
+            m_pimpl->m_transaction_pool.length() < BLOCK_MAX_TRANSACTIONS / 2 &&
+            NodeType::storage == m_pimpl->m_node_type &&
+            m_pimpl->m_slave_node &&
+            false == m_pimpl->m_file_uris_check_pending)
+        {
+            //  storage controller keeps per channel windows of requests in flight
+            //  and refills them here as soon as earlier requests complete
+            auto& impl = *m_pimpl.get();
+
+            unordered_map<string, beltpp::ip_address> map_nodeid_ip_address;
+            unordered_set<string> set_resolved_nodeids;
+
+            PublicAddressesInfo public_addresses = impl.m_nodeid_service.get_addresses();
+            for (auto const& item : public_addresses.addresses_info)
+            {
+                if (item.seconds_since_checked > 2 * PUBLIC_ADDRESS_FRESH_THRESHHOLD_SECONDS)
+                    break;
+
+                NodeType check_role;
+                if (impl.m_state.get_role(item.node_address, check_role) &&
+                    check_role == NodeType::channel)
+                {
+                    set_resolved_nodeids.insert(item.node_address);
+                    beltpp::assign(map_nodeid_ip_address[item.node_address], item.ip_address);
+                }
+            }
+
+            auto file_to_channel =
+                    impl.m_storage_controller.get_file_requests(set_resolved_nodeids);
+
+            auto check_file_uris_callback = [&impl, file_to_channel, map_nodeid_ip_address](beltpp::packet&& package)
+            {
+                impl.m_file_uris_check_pending = false;
+
+                if (package.type() == BlockchainMessage::FileUris::rtt)
+                {
+                    BlockchainMessage::FileUris file_uris;
+                    std::move(package).get(file_uris);
+
+                    unordered_set<string> set_file_uris;
+                    set_file_uris.reserve(file_uris.file_uris.size());
+
+                    for (auto& file_uri : file_uris.file_uris)
+                        set_file_uris.insert(std::move(file_uri));
+
+                    using actions_vector = vector<unique_ptr<meshpp::session_action<meshpp::nodeid_session_header>>>;
+                    unordered_map<string, actions_vector> map_actions;
+                    unordered_map<string, pair<string, bool>> map_broadcast;
+
+                    for (auto const& item : file_to_channel)
+                    {
+                        auto const& file_uri = item.first;
+                        auto const& channel_address = item.second;
+
+                        if (0 == set_file_uris.count(file_uri))
+                        {
+                            auto& actions = map_actions[channel_address];
+                            if (actions.empty())
+                            {
+                                actions.emplace_back(new session_action_connections(*impl.m_ptr_rpc_socket.get()));
+                                actions.emplace_back(new session_action_signatures(*impl.m_ptr_rpc_socket.get(),
+                                                                                   impl.m_nodeid_service));
+                            }
+
+                            actions.emplace_back(new session_action_request_file(file_uri,
+                                                                                 item.second,
+                                                                                 impl));
+                        }
+                        else
+                        {
+                            map_broadcast[file_uri] = {channel_address, true};
+                        }
+                    }
+
+                    beltpp::finally guard_map_broadcast([&impl, &map_broadcast]
+                    {
+                        for (auto const& item : map_broadcast)
+                        {
+                            auto const& file_uri = item.first;
+                            auto const& channel_address = item.second.first;
+
+                            if (item.second.second)
+                            {
+#ifdef EXTRA_LOGGING
+                                impl.writeln_node(file_uri + " session_action_check_file_uris callback calling initiate revert");
+#endif
+                                impl.m_storage_controller.initiate(file_uri, channel_address, storage_controller::revert);
+                            }
+                        }
+                    });
+
+                    for (auto& actions : map_actions)
+                    {
+                        meshpp::nodeid_session_header header;
+                        header.nodeid = actions.first;
+                        header.address = map_nodeid_ip_address.at(actions.first);
+                        impl.m_nodeid_sessions.add(header,
+                                                   std::move(actions.second),
+                                                   chrono::minutes(3));
+                    }
+
+                    for (auto& item : map_broadcast)
+                    {
+                        auto const& file_uri = item.first;
+                        auto const& channel_address = item.second.first;
+#ifdef EXTRA_LOGGING
+                        beltpp::on_failure guard([&impl, file_uri]{impl.writeln_node(file_uri + " flew");});
+#endif
+                        if (false == impl.m_documents.storage_has_uri(file_uri, impl.m_pb_key.to_string()))
+                            broadcast_storage_update(impl, file_uri, UpdateType::store);
+
+#ifdef EXTRA_LOGGING
+                        impl.writeln_node(file_uri + " session_action_check_file_uris callback calling pop");
+#endif
+                        impl.m_storage_controller.initiate(file_uri, channel_address, storage_controller::revert);
+                        item.second.second = false;
+                        impl.m_storage_controller.pop(file_uri, channel_address);
+#ifdef EXTRA_LOGGING
+                        guard.dismiss();
+#endif
+                    }
+                }
+                else
+                {
+                    if (package.type() == BlockchainMessage::RemoteError::rtt)
+                    {
+                        BlockchainMessage::RemoteError remote_error;
+                        std::move(package).get(remote_error);
+#ifdef EXTRA_LOGGING
+                        impl.writeln_node(remote_error.message);
+#endif
+                    }
+#ifdef EXTRA_LOGGING
+                    else
+                    {
+                        impl.writeln_node("cannot get the files list - " + package.to_string());
+                    }
+                    impl.writeln_node("session_action_check_file_uris callback calling initiate revert " + std::to_string(file_to_channel.size()));
+#endif
+                    for (auto const& item : file_to_channel)
+                        impl.m_storage_controller.initiate(item.first, item.second, storage_controller::revert);
+                }
+            };
+
+            if (false == file_to_channel.empty())
+            {
+#ifdef EXTRA_LOGGING
+                m_pimpl->writeln_node("can download now: " + std::to_string(file_to_channel.size()));
+                impl.writeln_node("verified channels: " + std::to_string(map_nodeid_ip_address.size()));
+#endif
+                //  ask the slave only about the files of this refill
+                vector<string> file_uris;
+                file_uris.reserve(file_to_channel.size());
+                for (auto const& item : file_to_channel)
+                    file_uris.push_back(item.first);
+
+                vector<unique_ptr<meshpp::session_action<meshpp::session_header>>> actions;
+                actions.emplace_back(new session_action_check_file_uris(impl,
+                                                                        file_uris,
+                                                                        check_file_uris_callback));
+
+                meshpp::session_header header;
+                header.peerid = "slave";
+                m_pimpl->m_sessions.add(header,
+                                        std::move(actions),
+                                        chrono::minutes(1));
+
+                m_pimpl->m_file_uris_check_pending = true;
+            }
+        }
+
+        if (NodeType::storage == m_pimpl->m_node_type &&
+            m_pimpl->m_slave_node &&
+            m_pimpl->blockchain_updated())
+            storage_gc_worker(*m_pimpl.get());
+    }
+}
+
+void process_wait_result(unique_ptr<detail::node_internals>& m_pimpl,
+                         detail::wait_result_item& wait_result)
+{
     if (wait_result.et == detail::wait_result_item::event)
     {
         auto peerid = wait_result.peerid;
@@ -186,6 +492,11 @@ void node::run(bool& stop_check)
 
                         m_pimpl->add_peer(peerid);
 
+                        //  let the peer know it can exchange transaction inventories
+                        m_pimpl->m_p2p_send_queue.send(peerid,
+                                                       beltpp::packet(TransactionInventory()),
+                                                       send_queue::transactions);
+
                         beltpp::ip_address external_address =
                                 m_pimpl->m_ptr_p2p_socket->external_address();
                         assert(external_address.local.empty() == false);
@@ -243,6 +554,7 @@ void node::run(bool& stop_check)
                 case Role::rtt:
                 case StorageUpdate::rtt:
                 case ServiceStatistics::rtt:
+                case CompactServiceStatistics::rtt:
                 case SponsorContentUnit::rtt:
                 case CancelSponsorContentUnit::rtt:
                 {
@@ -263,20 +575,15 @@ void node::run(bool& stop_check)
                     assert(p_broadcast);
                     assert(p_signed_tx);
 
-                    Broadcast& broadcast = *p_broadcast;
                     SignedTransaction& signed_tx = *p_signed_tx;
 
                     if (action_process_on_chain(signed_tx, *m_pimpl.get()))
-                    {
-                        broadcast_message(std::move(broadcast),
-                                          m_pimpl->m_ptr_p2p_socket->name(),
-                                          peerid,
-                                          it == detail::wait_result_item::interface_type::rpc,
-                                          nullptr,
-                                          m_pimpl->m_p2p_peers,
-                                          m_pimpl->m_ptr_p2p_socket.get());
-                    }
-                
+                        m_pimpl->m_transaction_inventory.announce(signed_tx);
+
+                    //  the sender does not need to hear about it back
+                    if (it == detail::wait_result_item::interface_type::p2p)
+                        m_pimpl->m_transaction_inventory.known(peerid, meshpp::hash(signed_tx.to_string()));
+
                     if (it == detail::wait_result_item::interface_type::rpc)
                         psk->send(peerid, beltpp::packet(Done()));
 
@@ -430,6 +737,43 @@ void node::run(bool& stop_check)
 
                     break;
                 }
+                case FileUrisPageRequest::rtt:
+                {
+                    if (NodeType::blockchain == m_pimpl->m_node_type ||
+                        nullptr == m_pimpl->m_slave_node ||
+                        it != detail::wait_result_item::interface_type::rpc ||
+                        m_pimpl->m_ptr_rpc_socket->get_peer_type(peerid) != beltpp::socket::peer_type::streaming_accepted)
+                        throw wrong_request_exception("Do not disturb!");
+
+                    FileUrisPageRequest page_request;
+                    std::move(ref_packet).get(page_request);
+
+                    uint64_t max_count = page_request.max_count;
+                    if (0 == max_count || max_count > STORAGE_FILE_URIS_PAGE_SIZE)
+                        max_count = STORAGE_FILE_URIS_PAGE_SIZE;
+
+                    std::function<void(beltpp::packet&&)> callback_lambda =
+                            [psk, peerid](beltpp::packet&& package)
+                    {
+                        if (false == package.empty())
+                            psk->send(peerid, std::move(package));
+                    };
+
+                    vector<unique_ptr<meshpp::session_action<meshpp::session_header>>> actions;
+                    actions.emplace_back(new session_action_get_file_uris_page(*m_pimpl.get(),
+                                                                               page_request.start_after,
+                                                                               max_count,
+                                                                               page_request.stream,
+                                                                               callback_lambda));
+
+                    meshpp::session_header header;
+                    header.peerid = "slave";
+                    m_pimpl->m_sessions.add(header,
+                                            std::move(actions),
+                                            chrono::minutes(page_request.stream ? 10 : 1));
+
+                    break;
+                }
                 case LoggedTransactionsRequest::rtt:
                 {
                     if (it == detail::wait_result_item::interface_type::rpc)
@@ -497,7 +841,7 @@ void node::run(bool& stop_check)
                     else
                         sync_response.promised_header = m_pimpl->all_sync_info.own_sync_info();
 
-                    psk->send(peerid, beltpp::packet(std::move(sync_response)));
+                    m_pimpl->m_p2p_send_queue.send(peerid, beltpp::packet(std::move(sync_response)), send_queue::consensus);
 
                     break;
                 }
@@ -526,6 +870,95 @@ void node::run(bool& stop_check)
 
                     break;
                 }
+                case CompactBlockRequest::rtt:
+                {
+                    if (it != detail::wait_result_item::interface_type::p2p)
+                        throw wrong_request_exception("CompactBlockRequest received through rpc!");
+
+                    CompactBlockRequest compact_block_request;
+                    std::move(ref_packet).get(compact_block_request);
+
+                    session_action_block::process_request(peerid,
+                                                          compact_block_request,
+                                                          *m_pimpl.get());
+
+                    break;
+                }
+                case BlockTransactionsRequest::rtt:
+                {
+                    if (it != detail::wait_result_item::interface_type::p2p)
+                        throw wrong_request_exception("BlockTransactionsRequest received through rpc!");
+
+                    BlockTransactionsRequest block_transactions_request;
+                    std::move(ref_packet).get(block_transactions_request);
+
+                    session_action_block::process_request(peerid,
+                                                          block_transactions_request,
+                                                          *m_pimpl.get());
+
+                    break;
+                }
+                case TransactionInventory::rtt:
+                {
+                    if (it != detail::wait_result_item::interface_type::p2p)
+                        throw wrong_request_exception("TransactionInventory received through rpc!");
+
+                    TransactionInventory transaction_inventory;
+                    std::move(ref_packet).get(transaction_inventory);
+
+                    if (transaction_inventory.transaction_hashes.size() > TRANSACTION_INVENTORY_MAX_LENGTH)
+                        throw wrong_data_exception("too many transactions in inventory");
+
+                    //  an empty inventory is sent on join to say the peer speaks it
+                    m_pimpl->m_transaction_inventory.inventory_peer(peerid);
+
+                    if (m_pimpl->m_blockchain.length() >= m_pimpl->m_freeze_before_block)
+                        break;
+
+                    TransactionInventoryRequest inventory_request;
+                    for (auto& transaction_hash : transaction_inventory.transaction_hashes)
+                    {
+                        if (false == m_pimpl->m_transaction_cache.contains(transaction_hash) &&
+                            m_pimpl->m_transaction_inventory.announced(peerid, transaction_hash))
+                            inventory_request.transaction_hashes.push_back(std::move(transaction_hash));
+                    }
+
+                    if (false == inventory_request.transaction_hashes.empty())
+                        m_pimpl->m_p2p_send_queue.send(peerid, beltpp::packet(std::move(inventory_request)), send_queue::transactions);
+
+                    break;
+                }
+                case TransactionInventoryRequest::rtt:
+                {
+                    if (it != detail::wait_result_item::interface_type::p2p)
+                        throw wrong_request_exception("TransactionInventoryRequest received through rpc!");
+
+                    TransactionInventoryRequest inventory_request;
+                    std::move(ref_packet).get(inventory_request);
+
+                    if (inventory_request.transaction_hashes.size() > TRANSACTION_INVENTORY_MAX_LENGTH)
+                        throw wrong_data_exception("too many transactions requested");
+
+                    m_pimpl->m_transaction_inventory.inventory_peer(peerid);
+
+                    for (auto const& transaction_hash : inventory_request.transaction_hashes)
+                    {
+                        SignedTransaction const* p_signed_transaction =
+                                m_pimpl->m_transaction_inventory.find(transaction_hash);
+
+                        //  the transaction may have already left the inventory
+                        if (nullptr == p_signed_transaction)
+                            continue;
+
+                        Broadcast broadcast;
+                        broadcast.echoes = 0;
+                        broadcast.package = *p_signed_transaction;
+
+                        m_pimpl->m_p2p_send_queue.send(peerid, beltpp::packet(std::move(broadcast)), send_queue::transactions);
+                    }
+
+                    break;
+                }
                 case TransactionBroadcastRequest::rtt:
                 {
                     TransactionBroadcastRequest transaction_broadcast_request;
@@ -549,22 +982,12 @@ void node::run(bool& stop_check)
                                                 *m_pimpl.get());
 
                     if (action_process_on_chain(signed_transaction, *m_pimpl.get()))
-                    {
-                        BlockchainMessage::Broadcast broadcast;
-                        broadcast.echoes = 2;
-                        broadcast.package = std::move(signed_transaction);
-
-                        broadcast_message(std::move(broadcast),
-                                          m_pimpl->m_ptr_p2p_socket->name(),
-                                          peerid,
-                                          it == detail::wait_result_item::interface_type::rpc,
-                                          //m_pimpl->plogger_node,
-                                          nullptr,
-                                          m_pimpl->m_p2p_peers,
-                                          m_pimpl->m_ptr_p2p_socket.get());
-                    }
+                        m_pimpl->m_transaction_inventory.announce(signed_transaction);
 
-                    psk->send(peerid, beltpp::packet(std::move(transaction_done)));
+                    if (it == detail::wait_result_item::interface_type::p2p)
+                        m_pimpl->m_p2p_send_queue.send(peerid, beltpp::packet(std::move(transaction_done)), send_queue::transactions);
+                    else
+                        psk->send(peerid, beltpp::packet(std::move(transaction_done)));
 
                     break;
                 }
@@ -577,7 +1000,10 @@ void node::run(bool& stop_check)
                     auto signed_message = m_pimpl->m_pv_key.sign(message_pong);
 
                     msg_pong.signature = std::move(signed_message.base58);
-                    psk->send(peerid, beltpp::packet(std::move(msg_pong)));
+                    if (it == detail::wait_result_item::interface_type::p2p)
+                        m_pimpl->m_p2p_send_queue.send(peerid, beltpp::packet(std::move(msg_pong)), send_queue::consensus);
+                    else
+                        psk->send(peerid, beltpp::packet(std::move(msg_pong)));
                     break;
                 }
                 case Served::rtt:
@@ -804,330 +1230,66 @@ void node::run(bool& stop_check)
                 RemoteError msg;
                 msg.message = "unknown exception";
                 psk->send(peerid, beltpp::packet(msg));
-            }
-            throw;
-        }
-    }
-    else if (wait_result.et == detail::wait_result_item::timer)
-    {
-        m_pimpl->m_ptr_p2p_socket->timer_action();
-        m_pimpl->m_ptr_rpc_socket->timer_action();
-    }
-    else if (m_pimpl->m_slave_node && wait_result.et == detail::wait_result_item::on_demand)
-    {
-        auto ref_packet = std::move(wait_result.packet);
-
-        if (false == m_pimpl->m_sessions.process("slave", std::move(ref_packet)))
-        {
-            switch (ref_packet.type())
-            {
-            case StorageTypes::ContainerMessage::rtt:
-            {
-                StorageTypes::ContainerMessage msg_container;
-                std::move(ref_packet).get(msg_container);
-
-                if (msg_container.package.type() == Served::rtt)
-                {
-                    Served msg;
-                    std::move(msg_container.package).get(msg);
-                    if (m_pimpl->m_node_type == NodeType::storage)
-                    {
-                        detail::service_counter::service_unit unit;
-                        detail::service_counter::service_unit_counter unit_counter;
-
-                        string& channel_address = unit.peer_address;
-                        string storage_address;
-
-                        if (storage_utility::rpc::verify_storage_order(msg.storage_order_token,
-                                                                       channel_address,
-                                                                       storage_address,
-                                                                       unit.file_uri,
-                                                                       unit.content_unit_uri,
-                                                                       unit_counter.session_id,
-                                                                       unit_counter.seconds,
-                                                                       unit_counter.time_point) &&
-                            storage_address == m_pimpl->m_pb_key.to_string() &&
-                            m_pimpl->m_documents.file_exists(unit.file_uri))
-                        {
-                            unit.content_unit_uri.clear(); // simulate the old behavior
-
-                            m_pimpl->service_counter.served(unit, unit_counter);
-#ifdef EXTRA_LOGGING
-                            m_pimpl->writeln_node("storage served");
-                            m_pimpl->writeln_node(msg.to_string());
-#endif
-                        }
-
-                    }
-                }
-                break;
-            }
-            }
-        }   // if not processed by sessions
-    }
-
-    m_pimpl->m_sessions.erase_all_pending();
-    m_pimpl->m_sync_sessions.erase_all_pending();
-    m_pimpl->m_nodeid_sessions.erase_all_pending();
-
-    // broadcast own transactions to all peers for the case
-    // when node could not do this when received it through rpc
-    if (m_pimpl->m_broadcast_timer.expired() && !m_pimpl->m_p2p_peers.empty())
-    {
-        m_pimpl->m_broadcast_timer.update();
-
-        size_t pool_size = m_pimpl->m_transaction_pool.length();
-        if (pool_size > 0 && m_pimpl->blockchain_updated())
-        {
-            //m_pimpl->writeln_node("broadcasting old stored transactions to all peers");
-
-            auto current_time = system_clock::now();
-
-            for (size_t pool_index = 0; pool_index != pool_size; ++pool_index)
-            {
-                SignedTransaction const& signed_transaction = m_pimpl->m_transaction_pool.at(pool_index);
-
-                if (current_time < system_clock::from_time_t(signed_transaction.transaction_details.expiry.tm) &&
-                    current_time > system_clock::from_time_t(signed_transaction.transaction_details.creation.tm) + chrono::seconds(BLOCK_MINE_DELAY))
-                {
-                    Broadcast broadcast;
-                    broadcast.echoes = 2;
-                    broadcast.package = signed_transaction;
-
-                    broadcast_message(std::move(broadcast),
-                                      m_pimpl->m_ptr_p2p_socket->name(),
-                                      m_pimpl->m_ptr_p2p_socket->name(),
-                                      true, // like from rpc
-                                      nullptr, // no logger
-                                      m_pimpl->m_p2p_peers,
-                                      m_pimpl->m_ptr_p2p_socket.get());
-                }
-            }
-        }
-    }
-
-    // clean old transaction keys from cache
-    // to minimize it and make it work faster
-    if (m_pimpl->m_cache_cleanup_timer.expired())
-    {
-        m_pimpl->m_cache_cleanup_timer.update();
-
-        m_pimpl->clean_transaction_cache();
-
-        //  temp place
-        m_pimpl->m_nodeid_service.take_actions([this](std::string const& node_address,
-                                                      beltpp::ip_address const& address,
-                                                      std::unique_ptr<session_action_broadcast_address_info>&& ptr_action)
-        {
-            vector<unique_ptr<meshpp::session_action<meshpp::nodeid_session_header>>> actions;
-            actions.emplace_back(new session_action_connections(*m_pimpl->m_ptr_rpc_socket.get()));
-            actions.emplace_back(new session_action_signatures(*m_pimpl->m_ptr_rpc_socket.get(),
-                                                                m_pimpl->m_nodeid_service));
-
-            actions.emplace_back(std::move(ptr_action));
-
-            meshpp::nodeid_session_header header;
-            header.nodeid = node_address;
-            header.address = address;
-            m_pimpl->m_nodeid_sessions.add(header,
-                                           std::move(actions),
-                                           chrono::minutes(1));
-        });
-
-        // collect verified channel addresses and send to slave node
-        if (m_pimpl->m_node_type == NodeType::storage &&
-            m_pimpl->m_slave_node)
-        {
-            StorageTypes::SetVerifiedChannels set_channels;
-
-            PublicAddressesInfo public_addresses = m_pimpl->m_nodeid_service.get_addresses();
-            for (auto const& item : public_addresses.addresses_info)
-            {
-                if (item.seconds_since_checked > 2 * PUBLIC_ADDRESS_FRESH_THRESHHOLD_SECONDS)
-                    break;
-
-                NodeType check_role;
-                if (m_pimpl->m_state.get_role(item.node_address, check_role) &&
-                    check_role == NodeType::channel)
-                {
-                    set_channels.channel_addresses.push_back(item.node_address);
-                }
-            }
-
-            m_pimpl->m_slave_node->send(beltpp::packet(std::move(set_channels)));
-            m_pimpl->m_slave_node->wake();
-        }
-
-        //  yes temp place still
-        broadcast_node_type(m_pimpl);
-        broadcast_address_info(m_pimpl);
+            }
+            throw;
+        }
     }
-
-    // init sync process and block mining
-    if (m_pimpl->m_check_timer.expired())
+    else if (wait_result.et == detail::wait_result_item::timer)
     {
-        m_pimpl->m_check_timer.update();
-
-        if (m_pimpl->m_blockchain.length() < m_pimpl->m_freeze_before_block)
-            sync_worker(*m_pimpl.get());
+        m_pimpl->m_ptr_p2p_socket->timer_action();
+        m_pimpl->m_ptr_rpc_socket->timer_action();
+    }
+    else if (m_pimpl->m_slave_node && wait_result.et == detail::wait_result_item::on_demand)
+    {
+        auto ref_packet = std::move(wait_result.packet);
 
-        if (m_pimpl->m_storage_sync_delay.expired() &&
-            m_pimpl->blockchain_updated() &&
-            m_pimpl->m_transaction_pool.length() < BLOCK_MAX_TRANSACTIONS / 2 &&
-            NodeType::storage == m_pimpl->m_node_type &&
-            m_pimpl->m_slave_node)
+        if (false == m_pimpl->m_sessions.process("slave", std::move(ref_packet)))
         {
-            auto& impl = *m_pimpl.get();
-
-            unordered_map<string, beltpp::ip_address> map_nodeid_ip_address;
-            unordered_set<string> set_resolved_nodeids;
-
-            PublicAddressesInfo public_addresses = impl.m_nodeid_service.get_addresses();
-            for (auto const& item : public_addresses.addresses_info)
+            switch (ref_packet.type())
             {
-                if (item.seconds_since_checked > 2 * PUBLIC_ADDRESS_FRESH_THRESHHOLD_SECONDS)
-                    break;
-
-                NodeType check_role;
-                if (impl.m_state.get_role(item.node_address, check_role) &&
-                    check_role == NodeType::channel)
-                {
-                    set_resolved_nodeids.insert(item.node_address);
-                    beltpp::assign(map_nodeid_ip_address[item.node_address], item.ip_address);
-                }
-            }
-
-            auto file_to_channel =
-                    impl.m_storage_controller.get_file_requests(set_resolved_nodeids);
-
-            auto get_file_uris_callback = [&impl, file_to_channel, map_nodeid_ip_address](beltpp::packet&& package)
+            case StorageTypes::ContainerMessage::rtt:
             {
-                if (package.type() == BlockchainMessage::FileUris::rtt)
-                {
-                    BlockchainMessage::FileUris file_uris;
-                    std::move(package).get(file_uris);
-
-                    unordered_set<string> set_file_uris;
-                    set_file_uris.reserve(file_uris.file_uris.size());
-
-                    for (auto& file_uri : file_uris.file_uris)
-                        set_file_uris.insert(std::move(file_uri));
-
-                    using actions_vector = vector<unique_ptr<meshpp::session_action<meshpp::nodeid_session_header>>>;
-                    unordered_map<string, actions_vector> map_actions;
-                    unordered_map<string, pair<string, bool>> map_broadcast;
+                StorageTypes::ContainerMessage msg_container;
+                std::move(ref_packet).get(msg_container);
 
-                    for (auto const& item : file_to_channel)
+                if (msg_container.package.type() == Served::rtt)
+                {
+                    Served msg;
+                    std::move(msg_container.package).get(msg);
+                    if (m_pimpl->m_node_type == NodeType::storage)
                     {
-                        auto const& file_uri = item.first;
-                        auto const& channel_address = item.second;
-
-                        if (0 == set_file_uris.count(file_uri))
-                        {
-                            auto& actions = map_actions[channel_address];
-                            if (actions.empty())
-                            {
-                                actions.emplace_back(new session_action_connections(*impl.m_ptr_rpc_socket.get()));
-                                actions.emplace_back(new session_action_signatures(*impl.m_ptr_rpc_socket.get(),
-                                                                                   impl.m_nodeid_service));
-                            }
+                        detail::service_counter::service_unit unit;
+                        detail::service_counter::service_unit_counter unit_counter;
 
-                            actions.emplace_back(new session_action_request_file(file_uri,
-                                                                                 item.second,
-                                                                                 impl));
-                        }
-                        else
-                        {
-                            map_broadcast[file_uri] = {channel_address, true};
-                        }
-                    }
+                        string& channel_address = unit.peer_address;
+                        string storage_address;
 
-                    beltpp::finally guard_map_broadcast([&impl, &map_broadcast]
-                    {
-                        for (auto const& item : map_broadcast)
+                        if (storage_utility::rpc::verify_storage_order(msg.storage_order_token,
+                                                                       channel_address,
+                                                                       storage_address,
+                                                                       unit.file_uri,
+                                                                       unit.content_unit_uri,
+                                                                       unit_counter.session_id,
+                                                                       unit_counter.seconds,
+                                                                       unit_counter.time_point) &&
+                            storage_address == m_pimpl->m_pb_key.to_string() &&
+                            m_pimpl->m_documents.file_exists(unit.file_uri))
                         {
-                            auto const& file_uri = item.first;
-                            auto const& channel_address = item.second.first;
+                            unit.content_unit_uri.clear(); // simulate the old behavior
 
-                            if (item.second.second)
-                            {
+                            m_pimpl->service_counter.served(unit, unit_counter);
 #ifdef EXTRA_LOGGING
-                                impl.writeln_node(file_uri + " session_action_get_file_uris callback calling initiate revert");
+                            m_pimpl->writeln_node("storage served");
+                            m_pimpl->writeln_node(msg.to_string());
 #endif
-                                impl.m_storage_controller.initiate(file_uri, channel_address, storage_controller::revert);
-                            }
                         }
-                    });
-
-                    for (auto& actions : map_actions)
-                    {
-                        meshpp::nodeid_session_header header;
-                        header.nodeid = actions.first;
-                        header.address = map_nodeid_ip_address.at(actions.first);
-                        impl.m_nodeid_sessions.add(header,
-                                                   std::move(actions.second),
-                                                   chrono::minutes(3));
-                    }
 
-                    for (auto& item : map_broadcast)
-                    {
-                        auto const& file_uri = item.first;
-                        auto const& channel_address = item.second.first;
-#ifdef EXTRA_LOGGING
-                        beltpp::on_failure guard([&impl, file_uri]{impl.writeln_node(file_uri + " flew");});
-#endif
-                        if (false == impl.m_documents.storage_has_uri(file_uri, impl.m_pb_key.to_string()))
-                            broadcast_storage_update(impl, file_uri, UpdateType::store);
-
-#ifdef EXTRA_LOGGING
-                        impl.writeln_node(file_uri + " session_action_get_file_uris callback calling pop");
-#endif
-                        impl.m_storage_controller.initiate(file_uri, channel_address, storage_controller::revert);
-                        item.second.second = false;
-                        impl.m_storage_controller.pop(file_uri, channel_address);
-#ifdef EXTRA_LOGGING
-                        guard.dismiss();
-#endif
-                    }
-                }
-                else
-                {
-                    if (package.type() == BlockchainMessage::RemoteError::rtt)
-                    {
-                        BlockchainMessage::RemoteError remote_error;
-                        std::move(package).get(remote_error);
-#ifdef EXTRA_LOGGING
-                        impl.writeln_node(remote_error.message);
-#endif
-                    }
-#ifdef EXTRA_LOGGING
-                    else
-                    {
-                        impl.writeln_node("cannot get the files list - " + package.to_string());
                     }
-                    impl.writeln_node("session_action_get_file_uris callback calling initiate revert " + std::to_string(file_to_channel.size()));
-#endif
-                    for (auto const& item : file_to_channel)
-                        impl.m_storage_controller.initiate(item.first, item.second, storage_controller::revert);
                 }
-            };
-
-            if (false == file_to_channel.empty())
-            {
-#ifdef EXTRA_LOGGING
-                m_pimpl->writeln_node("can download now: " + std::to_string(file_to_channel.size()));
-                impl.writeln_node("verified channels: " + std::to_string(map_nodeid_ip_address.size()));
-#endif
-                vector<unique_ptr<meshpp::session_action<meshpp::session_header>>> actions;
-                actions.emplace_back(new session_action_get_file_uris(impl, get_file_uris_callback));
-
-                meshpp::session_header header;
-                header.peerid = "slave";
-                m_pimpl->m_sessions.add(header,
-                                        std::move(actions),
-                                        chrono::minutes(1));
+                break;
             }
-        }
+            }
+        }   // if not processed by sessions
     }
 }
 
@@ -1140,10 +1302,73 @@ void node::set_slave_node(storage_node& slave_node)
 //#define log_log_log
 
 //  free functions
+//  lets the peers advertising the same chain prefetch
+//  block ranges ahead of the running block session
+void parallel_block_worker(detail::node_internals& impl)
+{
+    auto& parallel_download = impl.all_sync_info.parallel_download;
+    if (false == parallel_download.active())
+        return;
+
+    auto const now = steady_clock::now();
+    parallel_download.expire(now);
+
+    for (auto const& item : impl.all_sync_info.sync_responses)
+    {
+        auto const& peerid = item.first;
+        //  a peer that does not keep up with own outbound traffic is a poor helper
+        if (0 == impl.m_p2p_peers.count(peerid) ||
+            impl.m_p2p_send_queue.congested(peerid) ||
+            false == parallel_download.helper_fits(peerid, item.second.promised_header.block_hash))
+            continue;
+
+        uint64_t block_number_from, block_number_to;
+        if (false == parallel_download.assign(peerid,
+                                              impl.all_sync_info.sync_throughputs[peerid].block_batch,
+                                              now + chrono::milliseconds(2 * SYNC_BATCH_SLOW_RESPONSE),
+                                              block_number_from,
+                                              block_number_to))
+            break;
+
+        vector<unique_ptr<meshpp::session_action<meshpp::nodeid_session_header>>> actions;
+        actions.emplace_back(new session_action_block_range(impl,
+                                                            peerid,
+                                                            block_number_from,
+                                                            block_number_to));
+
+        meshpp::nodeid_session_header header;
+        header.nodeid = peerid;
+        header.address = impl.m_ptr_p2p_socket->info_connection(peerid);
+        impl.m_sync_sessions.add(header,
+                                 std::move(actions),
+                                 chrono::seconds(SYNC_TIMER));
+    }
+}
+
+//  a peer that has not answered the compact block request in time
+//  is told so through its sync session, that asks for the full block
+void compact_block_worker(detail::node_internals& impl)
+{
+    auto& all_sync_info = impl.all_sync_info;
+    if (all_sync_info.compact_block_peerid.empty() ||
+        steady_clock::now() < all_sync_info.compact_block_deadline)
+        return;
+
+    auto peerid = all_sync_info.compact_block_peerid;
+    all_sync_info.compact_block_peerid.clear();
+
+    RemoteError remote_error;
+    remote_error.message = "compact block request timed out";
+    impl.m_sync_sessions.process(peerid, beltpp::packet(std::move(remote_error)));
+}
+
 void block_worker(detail::node_internals& impl)
 {
     if (impl.all_sync_info.blockchain_sync_in_progress)
-        return;
+    {
+        compact_block_worker(impl);
+        return parallel_block_worker(impl);
+    }
 
     ///  clean old entries from votes map
     //
@@ -1162,33 +1387,17 @@ void block_worker(detail::node_internals& impl)
 
     ///  update the votes map, to consider latest sync responses
     //
-    // get the ip addresses
-    unordered_map<string, string> map_nodeid_ip_address;
-    for (auto const& peerid : impl.m_p2p_peers)
-        map_nodeid_ip_address[peerid] = impl.m_ptr_p2p_socket->info_connection(peerid).remote.address;
-
-    PublicAddressesInfo public_addresses = impl.m_nodeid_service.get_addresses();
-
-    for (auto const& item : public_addresses.addresses_info)
-    {
-        if (item.seconds_since_checked > PUBLIC_ADDRESS_FRESH_THRESHHOLD_SECONDS)
-            break;
-        if (impl.m_p2p_peers.count(item.node_address))
-            continue;
-
-        map_nodeid_ip_address[item.node_address] = item.ip_address.local.address;
-    }
+    impl.m_voter_index.refresh(impl.m_nodeid_service);
 
     // use the ip addresses, to keep one vote per ip address
     for (auto const& item : impl.all_sync_info.sync_responses)
     {
-        auto it_ip_address = map_nodeid_ip_address.find(item.first);
-        if (it_ip_address == map_nodeid_ip_address.end())
+        string const* str_ip_address = impl.m_voter_index.voter_ip_address(item.first);
+        if (nullptr == str_ip_address)
             continue;
-        string str_ip_address = it_ip_address->second;
-        auto& replacing = impl.m_votes[str_ip_address];
+        auto& replacing = impl.m_votes[*str_ip_address];
         auto voting = detail::node_internals::vote_info{
-                          impl.m_state.get_balance(item.first, state_layer::pool),
+                          impl.m_voter_index.stake(item.first, impl.m_state),
                           item.second.own_header.block_hash,
                           steady_clock_now};
         if (voting.stake <= replacing.stake)
@@ -1226,7 +1435,7 @@ void block_worker(detail::node_internals& impl)
     }
 
     auto own_vote = detail::node_internals::vote_info{
-                        impl.m_state.get_balance(impl.m_pb_key.to_string(), state_layer::pool),
+                        impl.m_voter_index.stake(impl.m_pb_key.to_string(), impl.m_state),
                         impl.m_blockchain.last_header_ex().block_hash,
                         steady_clock_now};
     {
@@ -1637,6 +1846,110 @@ void sync_worker(detail::node_internals& impl)
         }
     }
 }
+
+void storage_gc_worker(detail::node_internals& impl)
+{
+    string const own_address = impl.m_pb_key.to_string();
+
+    if (impl.m_storage_gc_timer.expired() &&
+        false == impl.m_storage_gc_listing_pending)
+    {
+        impl.m_storage_gc_timer.update();
+
+        //  the listing comes page by page, the candidates not met
+        //  during the whole pass are forgotten at its end
+        auto candidates = std::make_shared<unordered_map<string, steady_clock::time_point>>();
+
+        auto get_file_uris_callback = [&impl, own_address, candidates](beltpp::packet&& package)
+        {
+            if (package.type() != BlockchainMessage::FileUrisPage::rtt)
+            {
+                impl.m_storage_gc_listing_pending = false;
+                return;
+            }
+
+            FileUrisPage* pfile_uris;
+            package.get(pfile_uris);
+
+            auto const now = steady_clock::now();
+
+            for (auto const& file_uri : pfile_uris->file_uris)
+            {
+                if (impl.m_documents.storage_has_uri(file_uri, own_address) ||
+                    impl.m_storage_gc_queue.count(file_uri))
+                    continue;
+
+                //  a just stored file is not assigned until its storage update
+                //  transaction gets mined, so give it the grace period
+                auto it_candidate = impl.m_storage_gc_candidates.find(file_uri);
+                if (it_candidate == impl.m_storage_gc_candidates.end())
+                    (*candidates)[file_uri] = now;
+                else if (now - it_candidate->second < chrono::seconds(STORAGE_GC_GRACE_PERIOD))
+                    (*candidates)[file_uri] = it_candidate->second;
+                else
+                    impl.m_storage_gc_queue.insert(file_uri);
+            }
+
+            if (false == pfile_uris->more)
+            {
+                impl.m_storage_gc_candidates = std::move(*candidates);
+                impl.m_storage_gc_listing_pending = false;
+            }
+        };
+
+        vector<unique_ptr<meshpp::session_action<meshpp::session_header>>> actions;
+        actions.emplace_back(new session_action_get_file_uris_page(impl,
+                                                                   string(),
+                                                                   STORAGE_FILE_URIS_PAGE_SIZE,
+                                                                   true,
+                                                                   get_file_uris_callback));
+
+        meshpp::session_header header;
+        header.peerid = "slave";
+        impl.m_sessions.add(header,
+                            std::move(actions),
+                            chrono::minutes(10));
+
+        impl.m_storage_gc_listing_pending = true;
+    }
+
+    //  delete few files at a time, so that the slave keeps serving in between
+    if (0 == impl.m_storage_gc_deletes_pending &&
+        false == impl.m_storage_gc_queue.empty())
+    {
+        vector<unique_ptr<meshpp::session_action<meshpp::session_header>>> actions;
+
+        while (false == impl.m_storage_gc_queue.empty() &&
+               actions.size() < STORAGE_GC_BATCH)
+        {
+            string file_uri = *impl.m_storage_gc_queue.begin();
+            impl.m_storage_gc_queue.erase(impl.m_storage_gc_queue.begin());
+
+            if (impl.m_documents.storage_has_uri(file_uri, own_address))
+                continue;
+
+            ++impl.m_storage_gc_deletes_pending;
+            actions.emplace_back(new session_action_delete_file(impl,
+                                                                file_uri,
+                                                                [&impl, file_uri](beltpp::packet&& package)
+            {
+                --impl.m_storage_gc_deletes_pending;
+
+                if (package.type() == Done::rtt)
+                    impl.writeln_node("storage gc deleted not assigned file " + file_uri);
+            }));
+        }
+
+        if (false == actions.empty())
+        {
+            meshpp::session_header header;
+            header.peerid = "slave";
+            impl.m_sessions.add(header,
+                                std::move(actions),
+                                chrono::minutes(1));
+        }
+    }
+}
 }
 
 
@@ -12,6 +12,8 @@
 
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 #include <chrono>
 #include <map>
 
@@ -21,8 +23,10 @@ class storage_node;
 class coin;
 namespace detail
 {
+//  the views of one serving and owner channel pair, as content id and count
+//  pairs ordered by content id, then by unit uri and file uri
 using fp_counts_per_channel_views =
-uint64_t (*)(std::map<uint64_t, std::map<std::string, std::map<std::string, uint64_t>>> const& item_per_owner,
+uint64_t (*)(std::vector<std::pair<uint64_t, uint64_t>> const& content_views,
 uint64_t block_number,
 bool is_testnet);
 
@@ -28,23 +28,29 @@ bool node_internals::initialize()
         //  calculate back
         SignedBlock const& signed_block = m_blockchain.at(m_blockchain.last_header().block_number);
         m_blockchain.remove_last_block();
+        m_block_server.removed();
         m_action_log.revert();
 
         Block const& block = signed_block.block_details;
 
-        map<string, map<string, uint64_t>> unit_uri_view_counts;
-        map<string, coin> unit_sponsor_applied;
-        // verify block rewards before reverting, this also reclaims advertisement coins
-        if (check_rewards(block,
-                          signed_block.authorization.address,
-                          rewards_type::revert,
-                          *this,
-                          unit_uri_view_counts,
-                          unit_sponsor_applied))
-            writeln_node("Last (" + std::to_string(block.header.block_number) + ") block rewards reverting error!");
-
-        B_UNUSED(unit_uri_view_counts);
-        B_UNUSED(unit_sponsor_applied);
+        // restore the sponsored usage kept when the block was applied,
+        // for older blocks recompute and verify the rewards instead
+        if (false == m_documents.sponsored_undo_replay(block.header.block_number))
+        {
+            map<string, map<string, uint64_t>> unit_uri_view_counts;
+            map<string, coin> unit_sponsor_applied;
+            // verify block rewards before reverting, this also reclaims advertisement coins
+            if (check_rewards(block,
+                              signed_block.authorization.address,
+                              rewards_type::revert,
+                              *this,
+                              unit_uri_view_counts,
+                              unit_sponsor_applied))
+                writeln_node("Last (" + std::to_string(block.header.block_number) + ") block rewards reverting error!");
+
+            B_UNUSED(unit_uri_view_counts);
+            B_UNUSED(unit_sponsor_applied);
+        }
 
         // decrease all reward amounts from balances and revert reward
         for (auto it = block.rewards.crbegin(); it != block.rewards.crend(); ++it)
@@ -111,6 +117,8 @@ bool node_internals::initialize()
             throw std::runtime_error("the stored node role is different");
 
         load_transaction_cache(*this, false);
+        m_block_server.committing(m_blockchain.length(), m_blockchain.last_hash());
+        m_block_server.committed();
 
         m_initialize = false;
     }
@@ -118,8 +126,50 @@ bool node_internals::initialize()
     return stop_check;
 }
 
+consensus_delta const& node_internals::consensus()
+{
+    string head_hash = m_blockchain.last_hash();
+    if (head_hash == m_consensus.head_hash)
+        return m_consensus;
+
+    uint64_t block_number = m_blockchain.length() - 1;
+
+    vector<pair<uint64_t, uint64_t>> delta_vector;
+    size_t block_index = 0;
+    if (block_number + 1 >= DELTA_STEP)
+        block_index = block_number + 1 - DELTA_STEP;
+    for (; block_index <= block_number; ++block_index)
+    {
+        BlockHeader const& tmp_header = m_blockchain.header_at(block_index);
+        delta_vector.push_back(std::make_pair(tmp_header.delta, tmp_header.c_const));
+    }
+
+    assert(false == delta_vector.empty());
+
+    string check_delta_vector_error;
+    uint64_t c_const = check_delta_vector(delta_vector, check_delta_vector_error);
+    assert(check_delta_vector_error.empty());
+    if (false == check_delta_vector_error.empty())
+        throw std::logic_error("own blockchain is somehow wrong");
+
+    if (m_consensus.own_key_hash.empty())
+        m_consensus.own_key_hash = meshpp::hash(m_pb_key.to_string());
+
+    m_consensus.c_const = c_const;
+    m_consensus.own_distance = meshpp::distance(m_consensus.own_key_hash, head_hash);
+    m_consensus.head_hash = std::move(head_hash);
+
+    return m_consensus;
+}
+
 wait_result_item node_internals::wait_and_receive_one()
 {
+    auto result = wait_result_item::empty_result();
+
+    //  packets released by the transaction verifier go first
+    if (m_transaction_verifier.pop(result))
+        return result;
+
     auto& wait_result = m_wait_result.m_wait_result;
 
     if (wait_result == beltpp::event_handler::wait_result::nothing)
@@ -173,8 +223,6 @@ wait_result_item node_internals::wait_and_receive_one()
             m_wait_result.on_demand_packets = m_slave_node->receive();
     }
 
-    auto result = wait_result_item::empty_result();
-
     if (wait_result & beltpp::event_handler::event)
     {
         if (false == m_wait_result.event_packets.empty())
@@ -189,7 +237,10 @@ wait_result_item node_internals::wait_and_receive_one()
 
                 it->second.second.pop_front();
 
-                result = wait_result_item::event_result(interface_type, peerid, std::move(packet));
+                //  a broadcast transaction stays with the verifier for a while,
+                //  the packets after it from the same peer wait for it
+                m_transaction_verifier.push(wait_result_item::event_result(interface_type, peerid, std::move(packet)));
+                m_transaction_verifier.pop(result);
             }
 
             if (it->second.second.empty())
@@ -227,5 +278,25 @@ wait_result_item node_internals::wait_and_receive_one()
 
     return result;
 }
+
+std::deque<wait_result_item> node_internals::wait_and_receive()
+{
+    std::deque<wait_result_item> results;
+
+    //  waits only for the first one, then takes whatever is ready
+    do
+    {
+        auto result = wait_and_receive_one();
+        if (result.et != wait_result_item::nothing)
+            results.push_back(std::move(result));
+    }
+    while (m_wait_result.m_wait_result != beltpp::event_handler::wait_result::nothing);
+
+    auto result = wait_result_item::empty_result();
+    while (m_transaction_verifier.pop(result))
+        results.push_back(std::move(result));
+
+    return results;
+}
 }
 }
@@ -11,6 +11,9 @@
 #include "nodeid_service.hpp"
 #include "node_synchronization.hpp"
 #include "storage_node.hpp"
+#include "send_queue.hpp"
+#include "block_server.hpp"
+#include "transaction_verifier.hpp"
 
 #include <belt.pp/event.hpp>
 #include <belt.pp/socket.hpp>
@@ -27,7 +30,9 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/functional/hash.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <deque>
 #include <thread>
 #include <memory>
 #include <utility>
@@ -107,19 +112,47 @@ private:
             return hash_value;
         }
     };
-    struct service_unit_counter_hash
+    //  the counter with its unit replaced by the interned unit id
+    class counter_key
     {
-        size_t operator()(service_unit_counter const& value) const noexcept
+    public:
+        uint32_t unit_id;
+        string session_id;
+        system_clock::rep time_point;
+        uint64_t seconds;
+
+        bool operator == (counter_key const& other) const
+        {
+            return (unit_id == other.unit_id &&
+                    session_id == other.session_id &&
+                    time_point == other.time_point &&
+                    seconds == other.seconds);
+        }
+    };
+    struct counter_key_hash
+    {
+        size_t operator()(counter_key const& value) const noexcept
         {
             size_t hash_value = 0xdeadbeef;
+            boost::hash_combine(hash_value, value.unit_id);
             boost::hash_combine(hash_value, value.session_id);
-            boost::hash_combine(hash_value, system_clock::to_time_t(value.time_point));
+            boost::hash_combine(hash_value, value.time_point);
             boost::hash_combine(hash_value, value.seconds);
             return hash_value;
         }
     };
+    class unit_data
+    {
+    public:
+        service_unit unit;
+        //  counters in the buckets referring to this unit
+        uint64_t references = 0;
+        //  counters recorded since the last statistics were taken
+        uint64_t pending = 0;
+    };
 
-    using service_unit_counter_map = unordered_map<service_unit_counter, bool, service_unit_counter_hash>;
+    //  counters grouped by the time they expire at, in SERVICE_COUNTER_BUCKET_SECONDS
+    using counter_bucket = unordered_set<counter_key, counter_key_hash>;
 public:
     void served(service_unit const& unit,
                 service_unit_counter const& unit_counter)
@@ -131,10 +164,25 @@ public:
         if (unit_counter.time_point + chrono::seconds(unit_counter.seconds) <= now - chrono::seconds(NODES_TIME_SHIFT))
             throw std::logic_error("unit_counter.time_point + chrono::seconds(unit_counter.seconds) <= now - chrono::seconds(NODES_TIME_SHIFT)");
 
-        auto insert_res = m_served.insert({unit, service_unit_counter_map()});
-        insert_res.first->second.insert({unit_counter, false});
+        uint32_t unit_id = intern(unit);
+
+        auto expiry = unit_counter.time_point + chrono::seconds(unit_counter.seconds);
+        auto& bucket = m_buckets[bucket_index(expiry)];
+
+        //  the same counter reported again is counted once
+        if (false == bucket.insert({unit_id,
+                                    unit_counter.session_id,
+                                    unit_counter.time_point.time_since_epoch().count(),
+                                    unit_counter.seconds}).second)
+            return;
+
+        auto& data = m_units[unit_id];
+        ++data.references;
+        if (0 == data.pending++)
+            m_pending_ids.push_back(unit_id);
     }
 
+    //  counts recorded since the previous call, then forgets expired counters
     ServiceStatistics take_statistics_info()
     {
         struct index_helper
@@ -162,79 +210,97 @@ public:
         unordered_map<index_helper, size_t, hash_index_helper> index;
         ServiceStatistics service_statistics;
 
-        auto now = system_clock::now();
-
-        auto it = m_served.begin();
-        while (it != m_served.end())
+        for (uint32_t unit_id : m_pending_ids)
         {
-            auto const& unit = it->first;
-            auto& unit_counter_map = it->second;
+            auto& data = m_units[unit_id];
+            auto const& unit = data.unit;
 
             ServiceStatisticsCount stat_count;
             stat_count.peer_address = unit.peer_address;
-
-            auto unit_counter_it = unit_counter_map.begin();
-            while (unit_counter_it != unit_counter_map.end())
+            stat_count.count = data.pending;
+            data.pending = 0;
+
+            auto insert_result = index.insert({
+                                                  {unit.content_unit_uri, unit.file_uri},
+                                                  service_statistics.file_items.size()
+                                              });
+            if (insert_result.second)
             {
-                auto const& unit_counter = unit_counter_it->first;
-
-                bool expired = false;
-                if (unit_counter.time_point + chrono::seconds(unit_counter.seconds) <= now - chrono::seconds(NODES_TIME_SHIFT))
-                    expired = true;
-                bool& counted = unit_counter_it->second;
-
-                if (false == counted)
-                {
-                    ++stat_count.count;
-                    counted = true;
-                }
-
-                if (expired)
-                    unit_counter_it = unit_counter_map.erase(unit_counter_it);
-                else
-                    ++unit_counter_it;
+                ServiceStatisticsFile stat_file_local;
+                stat_file_local.file_uri = unit.file_uri;
+                stat_file_local.unit_uri = unit.content_unit_uri;
+                service_statistics.file_items.push_back(stat_file_local);
             }
 
-            if (stat_count.count)
-            {
-                auto const& file_uri = unit.file_uri;
-                auto const& content_unit_uri = unit.content_unit_uri;
-
-                ServiceStatisticsFile* pstat_file = nullptr;
-
-                auto insert_result = index.insert({
-                                                      {content_unit_uri, file_uri},
-                                                      service_statistics.file_items.size()
-                                                  });
-                if (false == insert_result.second)
-                {
-                    pstat_file = &service_statistics.file_items[insert_result.first->second];
-                }
-                else
-                {
-                    ServiceStatisticsFile stat_file_local;
-                    stat_file_local.file_uri = file_uri;
-                    stat_file_local.unit_uri = content_unit_uri;
-                    service_statistics.file_items.push_back(stat_file_local);
+            ServiceStatisticsFile& stat_file = service_statistics.file_items[insert_result.first->second];
+            stat_file.count_items.push_back(stat_count);
 
-                    pstat_file = &service_statistics.file_items.back();
-                }
+            if (0 == data.references)
+                release(unit_id);
+        }
+        m_pending_ids.clear();
 
-                ServiceStatisticsFile& stat_file = *pstat_file;
-                stat_file.count_items.push_back(stat_count);
+        //  a bucket goes when the last of its counters has expired
+        auto expired_before = bucket_index(system_clock::now() - chrono::seconds(NODES_TIME_SHIFT));
+        while (false == m_buckets.empty() &&
+               m_buckets.begin()->first < expired_before)
+        {
+            for (auto const& key : m_buckets.begin()->second)
+            {
+                auto& data = m_units[key.unit_id];
+                if (0 == --data.references && 0 == data.pending)
+                    release(key.unit_id);
             }
 
-            if (unit_counter_map.empty())
-                it = m_served.erase(it);
-            else
-                ++it;
-        };
+            m_buckets.erase(m_buckets.begin());
+        }
 
         return service_statistics;
     }
 
 private:
-    unordered_map<service_unit, service_unit_counter_map, service_unit_hash> m_served;
+    static int64_t bucket_index(system_clock::time_point const& time_point)
+    {
+        return chrono::duration_cast<chrono::seconds>(time_point.time_since_epoch()).count() /
+               SERVICE_COUNTER_BUCKET_SECONDS;
+    }
+
+    uint32_t intern(service_unit const& unit)
+    {
+        auto it = m_ids.find(unit);
+        if (it != m_ids.end())
+            return it->second;
+
+        uint32_t unit_id;
+        if (m_free_ids.empty())
+        {
+            unit_id = uint32_t(m_units.size());
+            m_units.push_back(unit_data());
+        }
+        else
+        {
+            unit_id = m_free_ids.back();
+            m_free_ids.pop_back();
+        }
+
+        m_units[unit_id].unit = unit;
+        m_ids.insert({unit, unit_id});
+
+        return unit_id;
+    }
+
+    void release(uint32_t unit_id)
+    {
+        m_ids.erase(m_units[unit_id].unit);
+        m_units[unit_id] = unit_data();
+        m_free_ids.push_back(unit_id);
+    }
+
+    vector<unit_data> m_units;
+    vector<uint32_t> m_free_ids;
+    vector<uint32_t> m_pending_ids;
+    unordered_map<service_unit, uint32_t, service_unit_hash> m_ids;
+    map<int64_t, counter_bucket> m_buckets;
 };
 
 class transaction_cache
@@ -352,6 +418,11 @@ public:
         return data.count(key) > 0;
     }
 
+    bool contains(string const& key) const
+    {
+        return data.count(key) > 0;
+    }
+
     void backup()
     {
         data_backup = data;
@@ -371,6 +442,390 @@ protected:
     unordered_map<string, data_type> data_backup;
 };
 
+class transaction_inventory
+{
+public:
+    //  the peer has sent an inventory message, so it understands them,
+    //  the rest get the transactions as full broadcasts
+    void inventory_peer(peer_id const& peerid)
+    {
+        inventory_peers.insert(peerid);
+    }
+
+    //  the peer has sent the transaction itself
+    void known(peer_id const& peerid, string const& key)
+    {
+        auto it = data.find(key);
+        if (it == data.end())
+            return;
+
+        it->second.peers.insert(peerid);
+        delivered(key, it->second);
+    }
+
+    //  own pool got the transaction, tell about it to everyone else
+    //  again means that the peers told before are told once more
+    string announce(SignedTransaction const& signed_transaction, bool again = false)
+    {
+        string key = meshpp::hash(signed_transaction.to_string());
+
+        auto& data_item = item(key);
+        if (nullptr == data_item.signed_transaction)
+            data_item.signed_transaction.reset(new SignedTransaction(signed_transaction));
+        delivered(key, data_item);
+
+        pending.push_back(std::make_pair(key, again));
+
+        return key;
+    }
+
+    //  the peer announced the transaction, true if it should be asked for now
+    bool announced(peer_id const& peerid, string const& key)
+    {
+        auto it = data.find(key);
+        if (it == data.end())
+        {
+            //  hashes nobody delivered yet are limited per announcer
+            size_t& count = unsolicited_counts[peerid];
+            if (count >= TRANSACTION_INVENTORY_MAX_UNSOLICITED)
+                return false;
+
+            ++count;
+            it = data.insert(std::make_pair(key, data_type())).first;
+            it->second.tp = steady_clock::now();
+            it->second.unsolicited_peerid = peerid;
+        }
+
+        auto& data_item = it->second;
+        data_item.peers.insert(peerid);
+        if (data_item.signed_transaction)
+            return false;
+
+        if (data_item.announcers.end() == std::find(data_item.announcers.begin(),
+                                                    data_item.announcers.end(),
+                                                    peerid))
+            data_item.announcers.push_back(peerid);
+
+        if (false == data_item.requested_from.empty())
+            return false;
+
+        data_item.requested_from = peerid;
+        data_item.requested = steady_clock::now();
+        requested_keys.insert(key);
+
+        return true;
+    }
+
+    //  the requests not answered in time move to the next announcer
+    unordered_map<peer_id, vector<string>> take_retries()
+    {
+        unordered_map<peer_id, vector<string>> result;
+        auto now = steady_clock::now();
+
+        auto it_key = requested_keys.begin();
+        while (it_key != requested_keys.end())
+        {
+            auto& data_item = data.at(*it_key);
+            if (now - data_item.requested < chrono::seconds(TRANSACTION_INVENTORY_REQUEST_TIMEOUT))
+            {
+                ++it_key;
+                continue;
+            }
+
+            auto it_announcer = std::find(data_item.announcers.begin(),
+                                          data_item.announcers.end(),
+                                          data_item.requested_from);
+            if (it_announcer != data_item.announcers.end())
+                data_item.announcers.erase(it_announcer);
+
+            if (data_item.announcers.empty())
+            {
+                //  wait for somebody to announce it again
+                data_item.requested_from.clear();
+                it_key = requested_keys.erase(it_key);
+                continue;
+            }
+
+            data_item.requested_from = data_item.announcers.front();
+            data_item.requested = now;
+            result[data_item.requested_from].push_back(*it_key);
+            ++it_key;
+        }
+
+        return result;
+    }
+
+    SignedTransaction const* find(string const& key) const
+    {
+        auto it = data.find(key);
+        if (it == data.end())
+            return nullptr;
+
+        return it->second.signed_transaction.get();
+    }
+
+    //  announcements gathered since the last call, per peer not knowing them yet
+    //  and the full transactions for the peers not speaking inventory
+    unordered_map<peer_id, vector<string>> take_announcements(unordered_set<peer_id> const& peers,
+                                                              unordered_map<peer_id, vector<string>>& broadcasts)
+    {
+        unordered_map<peer_id, vector<string>> result;
+
+        for (auto const& pending_item : pending)
+        {
+            auto it = data.find(pending_item.first);
+            if (it == data.end())
+                continue;
+
+            auto& data_item = it->second;
+            for (auto const& peerid : peers)
+            {
+                if (data_item.peers.count(peerid) ||
+                    (false == pending_item.second && data_item.told.count(peerid)))
+                    continue;
+
+                data_item.told.insert(peerid);
+                if (inventory_peers.count(peerid))
+                    result[peerid].push_back(pending_item.first);
+                else
+                    broadcasts[peerid].push_back(pending_item.first);
+            }
+        }
+        pending.clear();
+
+        return result;
+    }
+
+    void remove_peer(peer_id const& peerid)
+    {
+        for (auto& data_item : data)
+        {
+            data_item.second.peers.erase(peerid);
+            data_item.second.told.erase(peerid);
+
+            auto& announcers = data_item.second.announcers;
+            auto it_announcer = std::find(announcers.begin(), announcers.end(), peerid);
+            if (it_announcer != announcers.end() &&
+                data_item.second.requested_from != peerid)
+                announcers.erase(it_announcer);
+
+            //  a request to this peer will not be answered, retry right away
+            if (data_item.second.requested_from == peerid)
+                data_item.second.requested = steady_clock::time_point();
+        }
+
+        inventory_peers.erase(peerid);
+        unsolicited_counts.erase(peerid);
+    }
+
+    void clean()
+    {
+        auto now = steady_clock::now();
+
+        auto it = data.begin();
+        while (it != data.end())
+        {
+            if (now - it->second.tp > chrono::seconds(TRANSACTION_INVENTORY_LIFETIME))
+            {
+                delivered(it->first, it->second);
+                it = data.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+protected:
+    class data_type
+    {
+    public:
+        steady_clock::time_point tp;
+        steady_clock::time_point requested;
+        //  peers that have the transaction and the ones told about it
+        unordered_set<peer_id> peers;
+        unordered_set<peer_id> told;
+        //  peers that announced it, in order, while it is not here yet
+        vector<peer_id> announcers;
+        peer_id requested_from;
+        peer_id unsolicited_peerid;
+        unique_ptr<SignedTransaction> signed_transaction;
+    };
+
+    data_type& item(string const& key)
+    {
+        auto& data_item = data[key];
+        if (data_item.tp == steady_clock::time_point())
+            data_item.tp = steady_clock::now();
+
+        return data_item;
+    }
+
+    //  nothing more to ask for this transaction
+    void delivered(string const& key, data_type& data_item)
+    {
+        if (false == data_item.unsolicited_peerid.empty())
+        {
+            auto it = unsolicited_counts.find(data_item.unsolicited_peerid);
+            if (it != unsolicited_counts.end() && it->second > 0)
+                --it->second;
+            data_item.unsolicited_peerid.clear();
+        }
+
+        data_item.announcers.clear();
+        data_item.requested_from.clear();
+        requested_keys.erase(key);
+    }
+
+    unordered_map<string, data_type> data;
+    vector<pair<string, bool>> pending;
+    unordered_set<string> requested_keys;
+    unordered_set<peer_id> inventory_peers;
+    unordered_map<peer_id, size_t> unsolicited_counts;
+};
+
+//  shares validated from a block's service statistics, they depend only on
+//  the state at prev_hash and on the block transactions, so a block mined
+//  or checked once does not need its statistics validated again
+class statistics_cache
+{
+public:
+    class result
+    {
+    public:
+        std::multimap<string, pair<uint64_t, uint64_t>> author_result;
+        std::multimap<string, pair<uint64_t, uint64_t>> channel_result;
+        std::multimap<string, pair<uint64_t, uint64_t>> storage_result;
+        //  uri         channel   views
+        map<string, map<string, uint64_t>> unit_uri_view_counts;
+    };
+
+    static string key(BlockHeader const& block_header,
+                      vector<SignedTransaction> const& signed_transactions)
+    {
+        string buffer = block_header.prev_hash;
+        for (auto const& signed_transaction : signed_transactions)
+            buffer += signed_transaction.to_string();
+
+        return meshpp::hash(buffer);
+    }
+
+    result const* find(string const& key) const
+    {
+        auto it = data.find(key);
+        if (it == data.end())
+            return nullptr;
+
+        return &it->second;
+    }
+
+    void insert(string const& key, result const& value)
+    {
+        if (false == data.insert({key, value}).second)
+            return;
+
+        order.push_back(key);
+        if (order.size() > STATISTICS_CACHE_MAX_LENGTH)
+        {
+            data.erase(order.front());
+            order.pop_front();
+        }
+    }
+protected:
+    unordered_map<string, result> data;
+    std::deque<string> order;
+};
+
+//  voters' ip addresses and stakes kept between block_worker runs, peers are
+//  added and removed as they join and drop, the public address book is
+//  re-read every VOTER_INDEX_REFRESH_SECONDS, stakes are forgotten on any
+//  state change
+class voter_index
+{
+public:
+    voter_index()
+        : public_loaded(false)
+    {
+        public_refresh_timer.set(chrono::seconds(VOTER_INDEX_REFRESH_SECONDS));
+    }
+
+    void add_peer(peer_id const& peerid, string const& ip_address)
+    {
+        peer_ip_addresses[peerid] = ip_address;
+    }
+
+    void remove_peer(peer_id const& peerid)
+    {
+        peer_ip_addresses.erase(peerid);
+    }
+
+    void state_changed()
+    {
+        stakes.clear();
+    }
+
+    void refresh(nodeid_service const& service)
+    {
+        if (public_loaded &&
+            false == public_refresh_timer.expired())
+            return;
+
+        public_loaded = true;
+        public_refresh_timer.update();
+        public_ip_addresses.clear();
+
+        PublicAddressesInfo public_addresses = service.get_addresses();
+
+        for (auto const& item : public_addresses.addresses_info)
+        {
+            if (item.seconds_since_checked > PUBLIC_ADDRESS_FRESH_THRESHHOLD_SECONDS)
+                break;
+
+            public_ip_addresses[item.node_address] = item.ip_address.local.address;
+        }
+    }
+
+    //  connected peers take precedence over the public address book
+    string const* voter_ip_address(string const& nodeid) const
+    {
+        auto it = peer_ip_addresses.find(nodeid);
+        if (it != peer_ip_addresses.end())
+            return &it->second;
+
+        it = public_ip_addresses.find(nodeid);
+        if (it != public_ip_addresses.end())
+            return &it->second;
+
+        return nullptr;
+    }
+
+    coin const& stake(string const& address, publiqpp::state const& node_state)
+    {
+        auto it = stakes.find(address);
+        if (it == stakes.end())
+            it = stakes.insert({address, coin(node_state.get_balance(address, state_layer::pool))}).first;
+
+        return it->second;
+    }
+protected:
+    bool public_loaded;
+    beltpp::timer public_refresh_timer;
+    unordered_map<peer_id, string> peer_ip_addresses;
+    unordered_map<string, string> public_ip_addresses;
+    unordered_map<string, coin> stakes;
+};
+
+//  the delta vector check and the distance hashing depend only on the head,
+//  so they are kept here and redone when the head block changes
+class consensus_delta
+{
+public:
+    string head_hash;
+    //  c_const of the block to be mined on top of the head
+    uint64_t c_const = 0;
+    //  distance of own key hash from head_hash
+    uint64_t own_distance = 0;
+    string own_key_hash;
+};
+
 inline coin coin_from_fractions(uint64_t fractions)
 {
     coin result(0, 1);
@@ -378,24 +833,23 @@ inline coin coin_from_fractions(uint64_t fractions)
     return result;
 }
 
-using fp_counts_per_channel_views =
-uint64_t (*)(std::map<uint64_t, std::map<std::string, std::map<std::string, uint64_t>>> const& item_per_owner,
-uint64_t block_number,
-bool is_testnet);
 
-inline uint64_t counts_per_channel_views(map<uint64_t, map<string, map<string, uint64_t>>> const& item_per_owner,
+inline uint64_t counts_per_channel_views(vector<pair<uint64_t, uint64_t>> const& content_views,
                                          uint64_t /*block_number*/,
                                          bool /*is_testnet*/)
 {
     uint64_t count = 0;
-    for (auto const& item_per_content_id : item_per_owner)
+    uint64_t max_count_per_content_id = 0;
+    for (auto it = content_views.begin(); it != content_views.end(); ++it)
     {
-        uint64_t max_count_per_content_id = 0;
-        for (auto const& item_per_unit : item_per_content_id.second)
-        for (auto const& item_per_file : item_per_unit.second)
-            max_count_per_content_id = std::max(max_count_per_content_id, item_per_file.second);
+        max_count_per_content_id = std::max(max_count_per_content_id, it->second);
 
-        count += max_count_per_content_id;
+        if (it + 1 == content_views.end() ||
+            (it + 1)->first != it->first)
+        {
+            count += max_count_per_content_id;
+            max_count_per_content_id = 0;
+        }
     }
 
     return count;
@@ -446,12 +900,16 @@ public:
         , m_ptr_rpc_socket(new beltpp::socket(
                                beltpp::getsocket<rpc_sf>(*m_ptr_eh)
                                ))
+        , m_p2p_send_queue(*m_ptr_p2p_socket)
+        , m_block_server(fs_blockchain, *m_ptr_eh)
+        , m_transaction_verifier(*m_ptr_eh)
         , m_sync_timer()
         , m_check_timer()
         , m_broadcast_timer()
         , m_cache_cleanup_timer()
         , m_summary_report_timer()
         , m_storage_sync_delay()
+        , m_storage_gc_timer()
         , m_stuck_on_old_blockchain_timer()
         , m_public_address(public_address)
         , m_public_ssl_address(public_ssl_address)
@@ -470,6 +928,9 @@ public:
         , m_testnet(testnet)
         , m_transfer_only(transfer_only)
         , m_service_statistics_broadcast_triggered(false)
+        , m_file_uris_check_pending(false)
+        , m_storage_gc_listing_pending(false)
+        , m_storage_gc_deletes_pending(0)
         , m_initialize(true)
         , m_revert_blocks(revert_blocks)
         , m_freeze_before_block(freeze_before_block)
@@ -487,12 +948,14 @@ public:
         m_cache_cleanup_timer.set(chrono::seconds(CACHE_CLEANUP_TIMER));
         m_summary_report_timer.set(chrono::seconds(SUMMARY_REPORT_TIMER));
         m_storage_sync_delay.set(chrono::seconds(2 * CACHE_CLEANUP_TIMER));
+        m_storage_gc_timer.set(chrono::seconds(STORAGE_GC_TIMER));
         m_stuck_on_old_blockchain_timer.set(chrono::seconds(BLOCK_MINE_DELAY));
 
         m_ptr_eh->set_timer(chrono::seconds(EVENT_TIMER));
 
         m_broadcast_timer.update();
         m_storage_sync_delay.update();
+        m_storage_gc_timer.update();
 
         if (false == rpc_bind_to_address.local.empty())
             m_ptr_rpc_socket->listen(rpc_bind_to_address);
@@ -526,6 +989,8 @@ public:
 
         if (result.second == false)
             throw std::runtime_error("p2p peer already exists: " + peerid);
+
+        m_voter_index.add_peer(peerid, m_ptr_p2p_socket->info_connection(peerid).remote.address);
     }
 
     void remove_peer(socket::peer_id peerid)
@@ -534,6 +999,11 @@ public:
         m_sync_sessions.remove(peerid);
         m_nodeid_sessions.remove(peerid);
         m_sessions.remove(peerid);
+        all_sync_info.sync_throughputs.erase(peerid);
+        m_transaction_inventory.remove_peer(peerid);
+        m_p2p_send_queue.remove_peer(peerid);
+        m_block_server.remove_peer(peerid);
+        m_voter_index.remove_peer(peerid);
         if (0 == m_p2p_peers.erase(peerid))
             throw std::runtime_error("p2p peer not found to remove: " + peerid);
     }
@@ -548,11 +1018,17 @@ public:
 
         guard.dismiss();
 
+        //  the block server reads the blockchain files meanwhile
+        m_block_server.committing(m_blockchain.length(), m_blockchain.last_hash());
+
         m_state.commit();
         m_documents.commit();
         m_blockchain.commit();
         m_action_log.commit();
         m_transaction_pool.commit();
+
+        m_block_server.committed();
+        m_voter_index.state_changed();
     }
 
     void discard()
@@ -562,6 +1038,8 @@ public:
         m_blockchain.discard();
         m_action_log.discard();
         m_transaction_pool.discard();
+
+        m_voter_index.state_changed();
     }
 
     void clean_transaction_cache()
@@ -577,6 +1055,12 @@ public:
     uint64_t calc_delta(string const& key, uint64_t const& amount, string const& prev_hash, uint64_t const& cons_const)
     {
         uint64_t dist = meshpp::distance(meshpp::hash(key), prev_hash);
+        return calc_delta(dist, amount, cons_const);
+    }
+
+    static
+    uint64_t calc_delta(uint64_t dist, uint64_t const& amount, uint64_t const& cons_const)
+    {
         uint64_t delta = amount * DIST_MAX / ((dist + 1) * cons_const);
 
         if (delta > DELTA_MAX)
@@ -585,6 +1069,17 @@ public:
         return delta;
     }
 
+    //  consensus values for mining on top of the current head
+    consensus_delta const& consensus();
+
+    //  delta of the own block on top of the current head, at current balance
+    uint64_t own_delta()
+    {
+        return calc_delta(consensus().own_distance,
+                          get_balance().whole,
+                          m_blockchain.last_header().c_const);
+    }
+
     BlockchainMessage::Coin get_balance() const
     {
         return m_state.get_balance(m_pb_key.to_string(), state_layer::chain);
@@ -635,6 +1130,7 @@ public:
 
     bool initialize();
     wait_result_item wait_and_receive_one();
+    std::deque<wait_result_item> wait_and_receive();
 
     storage_node* m_slave_node;
     beltpp::ilog* plogger_p2p;
@@ -642,6 +1138,9 @@ public:
     unique_ptr<beltpp::event_handler> m_ptr_eh;
     unique_ptr<meshpp::p2psocket> m_ptr_p2p_socket;
     unique_ptr<beltpp::socket> m_ptr_rpc_socket;
+    send_queue m_p2p_send_queue;
+    block_server m_block_server;
+    transaction_verifier m_transaction_verifier;
 
     beltpp::timer m_sync_timer;
     beltpp::timer m_check_timer;
@@ -649,6 +1148,7 @@ public:
     beltpp::timer m_cache_cleanup_timer;
     beltpp::timer m_summary_report_timer;
     beltpp::timer m_storage_sync_delay;
+    beltpp::timer m_storage_gc_timer;
     beltpp::timer m_stuck_on_old_blockchain_timer;
 
     beltpp::ip_address m_public_address;
@@ -661,6 +1161,9 @@ public:
     publiqpp::state m_state;
     publiqpp::documents m_documents;
     publiqpp::storage_controller m_storage_controller;
+    //  channels that did not serve StorageFileChunkRequest,
+    //  till when to ask them for whole files instead
+    unordered_map<string, steady_clock::time_point> m_whole_file_channels;
 
     node_synchronization all_sync_info;
     detail::service_counter service_counter;
@@ -672,6 +1175,8 @@ public:
 
     unordered_set<beltpp::isocket::peer_id> m_p2p_peers;
     transaction_cache m_transaction_cache;
+    transaction_inventory m_transaction_inventory;
+    statistics_cache m_statistics_cache;
 
     NodeType m_node_type;
     coin m_fee_transactions;
@@ -681,6 +1186,9 @@ public:
     bool m_testnet;
     bool m_transfer_only;
     bool m_service_statistics_broadcast_triggered;
+    bool m_file_uris_check_pending;
+    bool m_storage_gc_listing_pending;
+    size_t m_storage_gc_deletes_pending;
     bool m_initialize;
     bool m_revert_blocks;
 
@@ -693,6 +1201,10 @@ public:
     std::vector<coin> const m_block_reward_array;
     fp_counts_per_channel_views pcounts_per_channel_views;
 
+    //  local files seen not assigned to this storage, and since when
+    unordered_map<string, steady_clock::time_point> m_storage_gc_candidates;
+    unordered_set<string> m_storage_gc_queue;
+
     struct vote_info
     {
         coin stake;
@@ -701,7 +1213,10 @@ public:
     };
 
     unordered_map<string, vote_info> m_votes;
+    voter_index m_voter_index;
+    consensus_delta m_consensus;
     wait_result m_wait_result;
+    std::deque<wait_result_item> m_wait_results;
 };
 
 }
@@ -5,13 +5,243 @@
 #include <belt.pp/meta.hpp>
 
 #include <chrono>
+#include <algorithm>
 
 using namespace BlockchainMessage;
 namespace chrono = std::chrono;
 using system_clock = chrono::system_clock;
+using std::string;
+using std::vector;
 
 namespace publiqpp
 {
+namespace
+{
+uint64_t smooth(uint64_t value, uint64_t sample)
+{
+    if (0 == value)
+        return sample;
+    return (3 * value + sample) / 4;
+}
+
+void adapt_batch(uint64_t& batch,
+                 uint64_t max_batch,
+                 size_t received,
+                 chrono::milliseconds elapsed)
+{
+    //  old peers serve less than asked, so grow only on full batches
+    if (elapsed > chrono::milliseconds(SYNC_BATCH_SLOW_RESPONSE))
+        batch = std::max(uint64_t(1), batch / 2);
+    else if (elapsed < chrono::milliseconds(SYNC_BATCH_FAST_RESPONSE) &&
+             received >= batch)
+        batch = std::min(max_batch, 2 * batch);
+}
+}
+
+sync_throughput::sync_throughput()
+    : header_batch(HEADER_TR_LENGTH + 1)
+    , block_batch(BLOCK_TR_LENGTH + 1)
+    , response_milliseconds(0)
+    , block_bytes_per_second(0)
+{}
+
+void sync_throughput::header_response(size_t received, chrono::steady_clock::duration elapsed)
+{
+    auto milliseconds = chrono::duration_cast<chrono::milliseconds>(elapsed);
+
+    response_milliseconds = smooth(response_milliseconds, uint64_t(milliseconds.count()));
+    adapt_batch(header_batch, HEADER_TR_MAX_LENGTH + 1, received, milliseconds);
+}
+
+void sync_throughput::block_response(size_t received, size_t bytes, chrono::steady_clock::duration elapsed)
+{
+    auto milliseconds = chrono::duration_cast<chrono::milliseconds>(elapsed);
+    uint64_t rate = 1000 * uint64_t(bytes) / std::max(uint64_t(1), uint64_t(milliseconds.count()));
+
+    response_milliseconds = smooth(response_milliseconds, uint64_t(milliseconds.count()));
+    block_bytes_per_second = smooth(block_bytes_per_second, rate);
+    adapt_batch(block_batch, BLOCK_TR_MAX_LENGTH + 1, received, milliseconds);
+}
+
+void blocks_download::start(beltpp::isocket::peer_id const& _main_peerid,
+                            vector<BlockHeaderExtended> const& headers)
+{
+    stop();
+
+    if (headers.empty())
+        return;
+
+    //  headers.front() has the highest index
+    main_peerid = _main_peerid;
+    tip_block_hash = headers.front().block_hash;
+    first_block_number = headers.back().block_number;
+    next_block_number = first_block_number;
+
+    block_hashes.reserve(headers.size());
+    for (auto it = headers.crbegin(); it != headers.crend(); ++it)
+        block_hashes.push_back(it->block_hash);
+}
+
+void blocks_download::stop()
+{
+    main_peerid.clear();
+    tip_block_hash.clear();
+    block_hashes.clear();
+    ranges.clear();
+    blocks.clear();
+    slow_peerids.clear();
+}
+
+bool blocks_download::active() const
+{
+    return false == block_hashes.empty();
+}
+
+void blocks_download::main_position(uint64_t block_number, uint64_t _main_batch)
+{
+    next_block_number = block_number;
+    main_batch = _main_batch;
+
+    blocks.erase(blocks.begin(), blocks.lower_bound(block_number));
+
+    auto it = ranges.begin();
+    while (it != ranges.end() && it->first < block_number)
+    {
+        if (it->second.block_number_to < block_number)
+            it = ranges.erase(it);
+        else
+            ++it;
+    }
+}
+
+bool blocks_download::helper_fits(beltpp::isocket::peer_id const& peerid,
+                                  string const& promised_block_hash) const
+{
+    if (false == active() ||
+        peerid == main_peerid ||
+        promised_block_hash != tip_block_hash ||
+        slow_peerids.count(peerid))
+        return false;
+
+    for (auto const& item : ranges)
+    {
+        if (item.second.peerid == peerid)
+            return false;
+    }
+
+    return true;
+}
+
+bool blocks_download::busy(uint64_t block_number) const
+{
+    if (blocks.count(block_number))
+        return true;
+
+    auto it = ranges.upper_bound(block_number);
+    if (it == ranges.begin())
+        return false;
+    --it;
+
+    return block_number <= it->second.block_number_to;
+}
+
+bool blocks_download::assign(beltpp::isocket::peer_id const& peerid,
+                             uint64_t batch,
+                             chrono::steady_clock::time_point deadline,
+                             uint64_t& block_number_from,
+                             uint64_t& block_number_to)
+{
+    if (false == active())
+        return false;
+
+    uint64_t last_block_number = std::min(first_block_number + uint64_t(block_hashes.size()) - 1,
+                                          next_block_number + SYNC_PARALLEL_WINDOW - 1);
+
+    //  the main peer brings the next batch itself
+    uint64_t block_number = next_block_number + main_batch;
+    while (block_number <= last_block_number && busy(block_number))
+        ++block_number;
+
+    if (block_number > last_block_number)
+        return false;
+
+    block_number_from = block_number;
+    block_number_to = block_number;
+    while (block_number_to < last_block_number &&
+           block_number_to + 1 < block_number_from + batch &&
+           false == busy(block_number_to + 1))
+        ++block_number_to;
+
+    ranges[block_number_from] = range{peerid, block_number_to, deadline};
+
+    return true;
+}
+
+void blocks_download::release(beltpp::isocket::peer_id const& peerid)
+{
+    auto it = ranges.begin();
+    while (it != ranges.end())
+    {
+        if (it->second.peerid == peerid)
+            it = ranges.erase(it);
+        else
+            ++it;
+    }
+}
+
+void blocks_download::expire(chrono::steady_clock::time_point now)
+{
+    //  the range of a slow peer becomes free for the others
+    auto it = ranges.begin();
+    while (it != ranges.end())
+    {
+        if (it->second.deadline < now)
+        {
+            slow_peerids.insert(it->second.peerid);
+            it = ranges.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+string blocks_download::block_hash(uint64_t block_number) const
+{
+    if (block_number < first_block_number ||
+        block_number - first_block_number >= block_hashes.size())
+        return string();
+
+    return block_hashes[block_number - first_block_number];
+}
+
+void blocks_download::deliver(vector<SignedBlock>&& signed_blocks)
+{
+    for (auto& signed_block : signed_blocks)
+    {
+        uint64_t block_number = signed_block.block_details.header.block_number;
+        if (block_number >= next_block_number &&
+            false == block_hash(block_number).empty())
+            blocks.insert(std::make_pair(block_number, std::move(signed_block)));
+    }
+}
+
+vector<SignedBlock> blocks_download::take(uint64_t block_number, size_t max_count)
+{
+    vector<SignedBlock> result;
+
+    auto it = blocks.find(block_number);
+    while (it != blocks.end() &&
+           it->first == block_number &&
+           result.size() < max_count)
+    {
+        result.push_back(std::move(it->second));
+        it = blocks.erase(it);
+        ++block_number;
+    }
+
+    return result;
+}
+
 node_synchronization::node_synchronization(detail::node_internals& impl)
     : pimpl(&impl)
     , blockchain_sync_in_progress(false)
@@ -46,10 +276,7 @@ BlockHeaderExtended node_synchronization::own_sync_info() const
     // calculate delta for next block for the case if I will mine it
     if (pimpl->is_miner())
     {
-        uint64_t delta = pimpl->calc_delta(pimpl->m_pb_key.to_string(),
-                                           pimpl->get_balance().whole,
-                                           result.block_hash,
-                                           result.c_const);
+        uint64_t delta = pimpl->own_delta();
 
         result.prev_hash = result.block_hash;
         result.block_hash.clear();
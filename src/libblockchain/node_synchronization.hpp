@@ -6,8 +6,12 @@
 #include <belt.pp/isocket.hpp>
 
 #include <vector>
+#include <string>
+#include <chrono>
 #include <utility>
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace publiqpp
 {
@@ -26,6 +30,70 @@ public:
     std::vector<BlockchainMessage::BlockHeaderExtended> headers;
 };
 
+//  sync batch sizes used with a peer, adapted to its response times
+class sync_throughput
+{
+public:
+    sync_throughput();
+
+    void header_response(size_t received, std::chrono::steady_clock::duration elapsed);
+    void block_response(size_t received, size_t bytes, std::chrono::steady_clock::duration elapsed);
+
+    uint64_t header_batch;
+    uint64_t block_batch;
+    //  smoothed values, zero until measured
+    uint64_t response_milliseconds;
+    uint64_t block_bytes_per_second;
+};
+
+//  block ranges of the chain being synced, prefetched from the peers that
+//  advertise the same chain, the block session consumes them in order
+class blocks_download
+{
+public:
+    class range
+    {
+    public:
+        beltpp::isocket::peer_id peerid;
+        uint64_t block_number_to;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    void start(beltpp::isocket::peer_id const& main_peerid,
+               std::vector<BlockchainMessage::BlockHeaderExtended> const& headers);
+    void stop();
+    bool active() const;
+
+    void main_position(uint64_t block_number, uint64_t main_batch);
+    bool helper_fits(beltpp::isocket::peer_id const& peerid,
+                     std::string const& promised_block_hash) const;
+    bool assign(beltpp::isocket::peer_id const& peerid,
+                uint64_t batch,
+                std::chrono::steady_clock::time_point deadline,
+                uint64_t& block_number_from,
+                uint64_t& block_number_to);
+    void release(beltpp::isocket::peer_id const& peerid);
+    void expire(std::chrono::steady_clock::time_point now);
+
+    std::string block_hash(uint64_t block_number) const;
+    void deliver(std::vector<BlockchainMessage::SignedBlock>&& signed_blocks);
+    std::vector<BlockchainMessage::SignedBlock> take(uint64_t block_number, size_t max_count);
+
+private:
+    bool busy(uint64_t block_number) const;
+
+    beltpp::isocket::peer_id main_peerid;
+    std::string tip_block_hash;
+    uint64_t first_block_number = 0;
+    //  ascending, starting from first_block_number
+    std::vector<std::string> block_hashes;
+    uint64_t next_block_number = 0;
+    uint64_t main_batch = 0;
+    std::map<uint64_t, range> ranges;
+    std::map<uint64_t, BlockchainMessage::SignedBlock> blocks;
+    std::unordered_set<beltpp::isocket::peer_id> slow_peerids;
+};
+
 class node_synchronization
 {
 public:
@@ -34,6 +102,13 @@ public:
     bool blockchain_sync_in_progress;
     std::unordered_map<beltpp::isocket::peer_id, BlockchainMessage::SyncResponse> sync_responses;
     std::unordered_map<beltpp::isocket::peer_id, headers_action_data> headers_actions_data;
+    std::unordered_map<beltpp::isocket::peer_id, sync_throughput> sync_throughputs;
+    blocks_download parallel_download;
+    //  the peer asked for a compact block and not answered yet,
+    //  and the peers that do not answer compact block requests
+    beltpp::isocket::peer_id compact_block_peerid;
+    std::chrono::steady_clock::time_point compact_block_deadline;
+    std::unordered_set<beltpp::isocket::peer_id> full_block_peerids;
     BlockchainMessage::BlockHeaderExtended net_sync_info() const;
     BlockchainMessage::BlockHeaderExtended own_sync_info() const;
 };
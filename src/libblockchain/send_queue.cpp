@@ -0,0 +1,182 @@
+#include "send_queue.hpp"
+#include "common.hpp"
+#include "message.hpp"
+
+using namespace BlockchainMessage;
+namespace chrono = std::chrono;
+using chrono::steady_clock;
+
+namespace publiqpp
+{
+namespace
+{
+//  rough serialized sizes, the queue only needs the order of magnitude
+//  and serializing every outgoing packet to measure it costs too much
+size_t const transaction_bytes = 1024;
+size_t const header_bytes = 512;
+size_t const hash_bytes = 64;
+size_t const other_bytes = 1024;
+
+size_t block_bytes(SignedBlock const& signed_block)
+{
+    return header_bytes +
+           header_bytes * signed_block.block_details.rewards.size() +
+           transaction_bytes * signed_block.block_details.signed_transactions.size();
+}
+
+size_t packet_bytes(beltpp::packet& package)
+{
+    switch (package.type())
+    {
+    case BlockchainResponse::rtt:
+    {
+        BlockchainResponse* pmsg;
+        package.get(pmsg);
+
+        size_t bytes = header_bytes;
+        for (auto const& signed_block : pmsg->signed_blocks)
+            bytes += block_bytes(signed_block);
+        return bytes;
+    }
+    case CompactBlock::rtt:
+    {
+        CompactBlock* pmsg;
+        package.get(pmsg);
+
+        return header_bytes +
+               header_bytes * pmsg->rewards.size() +
+               hash_bytes * pmsg->transaction_hashes.size();
+    }
+    case BlockTransactions::rtt:
+    {
+        BlockTransactions* pmsg;
+        package.get(pmsg);
+
+        return header_bytes + transaction_bytes * pmsg->signed_transactions.size();
+    }
+    case BlockHeaderResponse::rtt:
+    {
+        BlockHeaderResponse* pmsg;
+        package.get(pmsg);
+
+        return header_bytes * (pmsg->block_headers.size() + 1);
+    }
+    case TransactionInventory::rtt:
+    {
+        TransactionInventory* pmsg;
+        package.get(pmsg);
+
+        return hash_bytes * (pmsg->transaction_hashes.size() + 1);
+    }
+    case TransactionInventoryRequest::rtt:
+    {
+        TransactionInventoryRequest* pmsg;
+        package.get(pmsg);
+
+        return hash_bytes * (pmsg->transaction_hashes.size() + 1);
+    }
+    case Broadcast::rtt:
+        return transaction_bytes;
+    default:
+        return other_bytes;
+    }
+}
+}
+
+send_queue::send_queue(beltpp::isocket& sk)
+    : psk(&sk)
+    , queues()
+{}
+
+void send_queue::send(beltpp::isocket::peer_id const& peerid,
+                      beltpp::packet&& package,
+                      e_priority priority)
+{
+    size_t bytes = packet_bytes(package);
+
+    auto& queue = queues[peerid];
+    refill(queue, steady_clock::now());
+
+    //  nothing waits ahead, no need to hold it
+    //  consensus traffic does not wait for the budget, but spends it
+    if (0 == queue.queued_bytes &&
+        (priority == consensus ||
+         queue.budget > 0))
+    {
+        queue.budget -= double(bytes);
+        psk->send(peerid, std::move(package));
+        return;
+    }
+
+    queue.packets[priority].push_back(std::make_pair(std::move(package), bytes));
+    queue.queued_bytes += bytes;
+}
+
+void send_queue::flush()
+{
+    auto now = steady_clock::now();
+
+    auto it = queues.begin();
+    while (it != queues.end())
+    {
+        auto& queue = it->second;
+        refill(queue, now);
+
+        for (auto& packets : queue.packets)
+        {
+            //  a packet larger than the budget still goes out, with the
+            //  budget going negative until it is paid off
+            while (false == packets.empty() &&
+                   queue.budget > 0)
+            {
+                queue.budget -= double(packets.front().second);
+                queue.queued_bytes -= packets.front().second;
+
+                psk->send(it->first, std::move(packets.front().first));
+                packets.pop_front();
+            }
+        }
+
+        //  a full budget is the same as no entry at all
+        if (0 == queue.queued_bytes &&
+            queue.budget >= SEND_QUEUE_PEER_BYTES_PER_SECOND)
+            it = queues.erase(it);
+        else
+            ++it;
+    }
+}
+
+void send_queue::remove_peer(beltpp::isocket::peer_id const& peerid)
+{
+    queues.erase(peerid);
+}
+
+bool send_queue::congested(beltpp::isocket::peer_id const& peerid) const
+{
+    return queued_bytes(peerid) > SEND_QUEUE_CONGESTED_BYTES;
+}
+
+size_t send_queue::queued_bytes(beltpp::isocket::peer_id const& peerid) const
+{
+    auto it = queues.find(peerid);
+    if (it == queues.end())
+        return 0;
+
+    return it->second.queued_bytes;
+}
+
+void send_queue::refill(peer_queue& queue, steady_clock::time_point now)
+{
+    if (queue.budget_time == steady_clock::time_point())
+        queue.budget = SEND_QUEUE_PEER_BYTES_PER_SECOND;
+    else
+    {
+        auto elapsed = chrono::duration_cast<chrono::microseconds>(now - queue.budget_time);
+        queue.budget += double(SEND_QUEUE_PEER_BYTES_PER_SECOND) * double(elapsed.count()) / 1000000;
+        if (queue.budget > SEND_QUEUE_PEER_BYTES_PER_SECOND)
+            queue.budget = SEND_QUEUE_PEER_BYTES_PER_SECOND;
+    }
+
+    queue.budget_time = now;
+}
+}
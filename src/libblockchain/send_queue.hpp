@@ -0,0 +1,52 @@
+#pragma once
+
+#include "global.hpp"
+
+#include <belt.pp/isocket.hpp>
+#include <belt.pp/packet.hpp>
+
+#include <chrono>
+#include <deque>
+#include <utility>
+#include <unordered_map>
+
+namespace publiqpp
+{
+//  outbound packets per peer, sent in priority order so that a peer
+//  receiving blocks does not hold back consensus traffic
+//  a peer's socket is handed bytes at a fixed rate, the rest waits here,
+//  the socket does not tell how much it has written out yet, so what is
+//  queued here is the measure of a peer not keeping up
+class send_queue
+{
+public:
+    enum e_priority {consensus, blocks, transactions};
+
+    send_queue(beltpp::isocket& sk);
+
+    void send(beltpp::isocket::peer_id const& peerid,
+              beltpp::packet&& package,
+              e_priority priority);
+    void flush();
+    void remove_peer(beltpp::isocket::peer_id const& peerid);
+
+    //  the peer has more queued than its rate lets out soon
+    bool congested(beltpp::isocket::peer_id const& peerid) const;
+    size_t queued_bytes(beltpp::isocket::peer_id const& peerid) const;
+
+private:
+    class peer_queue
+    {
+    public:
+        std::deque<std::pair<beltpp::packet, size_t>> packets[transactions + 1];
+        size_t queued_bytes = 0;
+        double budget = 0;
+        std::chrono::steady_clock::time_point budget_time;
+    };
+
+    static void refill(peer_queue& queue, std::chrono::steady_clock::time_point now);
+
+    beltpp::isocket* psk;
+    std::unordered_map<beltpp::isocket::peer_id, peer_queue> queues;
+};
+}
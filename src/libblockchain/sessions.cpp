@@ -14,7 +14,9 @@
 #include <mesh.pp/cryptoutility.hpp>
 
 #include <algorithm>
+#include <iterator>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 namespace chrono = std::chrono;
@@ -247,7 +249,7 @@ void session_action_broadcast_address_info::initiate(meshpp::nodeid_session_head
                       true,
                       nullptr,
                       pimpl->m_p2p_peers,
-                      pimpl->m_ptr_p2p_socket.get());
+                      pimpl->m_p2p_send_queue);
 
     expected_next_package_type = size_t(-1);
     completed = true;
@@ -280,7 +282,10 @@ session_action_sync_request::~session_action_sync_request()
 
 void session_action_sync_request::initiate(meshpp::nodeid_session_header& header)
 {
-    psk->send(header.peerid, beltpp::packet(BlockchainMessage::SyncRequest()));
+    if (psk == pimpl->m_ptr_p2p_socket.get())
+        pimpl->m_p2p_send_queue.send(header.peerid, beltpp::packet(BlockchainMessage::SyncRequest()), send_queue::consensus);
+    else
+        psk->send(header.peerid, beltpp::packet(BlockchainMessage::SyncRequest()));
     expected_next_package_type = BlockchainMessage::SyncResponse::rtt;
 }
 
@@ -369,11 +374,18 @@ void session_action_header::_initiate(meshpp::nodeid_session_header& header, boo
     {
         current_peerid = header.peerid;
 
+        //  ask no more than the batch adapted for this peer
+        uint64_t header_batch = pimpl->all_sync_info.sync_throughputs[header.peerid].header_batch;
+        if (block_index_from >= header_batch &&
+            block_index_to < block_index_from - header_batch + 1)
+            block_index_to = block_index_from - header_batch + 1;
+
         BlockHeaderRequest header_request;
         header_request.blocks_from = block_index_from;
         header_request.blocks_to = block_index_to;
 
-        pimpl->m_ptr_p2p_socket->send(header.peerid, beltpp::packet(header_request));
+        request_time = steady_clock::now();
+        pimpl->m_p2p_send_queue.send(header.peerid, beltpp::packet(header_request), send_queue::consensus);
         expected_next_package_type = BlockchainMessage::BlockHeaderResponse::rtt;
     }
     else
@@ -434,19 +446,11 @@ void session_action_header::process_request(beltpp::isocket::peer_id const& peer
 
     uint64_t to = header_request.blocks_to;
     to = to > from ? from : to;
-    to = from > HEADER_TR_LENGTH && to < from - HEADER_TR_LENGTH ? from - HEADER_TR_LENGTH : to;
-
-    BlockHeaderResponse header_response;
-    for (auto index = from + 1; index > to; --index)
-    {
-        BlockHeaderExtended const& header = impl.m_blockchain.header_ex_at(index - 1);
+    to = from > HEADER_TR_MAX_LENGTH && to < from - HEADER_TR_MAX_LENGTH ? from - HEADER_TR_MAX_LENGTH : to;
 
-        header_response.block_headers.push_back(header);
-    }
-    //  header_response.block_headers has highest index - first element
-    //                                and lowest index - last element
-
-    impl.m_ptr_p2p_socket->send(peerid, beltpp::packet(header_response));
+    //  peers keep asking for the same recent ranges,
+    //  the blockchain keeps those responses ready
+    impl.m_p2p_send_queue.send(peerid, beltpp::packet(impl.m_blockchain.header_response(from, to)), send_queue::consensus);
 }
 
 void session_action_header::process_response(meshpp::nodeid_session_header& header,
@@ -458,9 +462,15 @@ void session_action_header::process_response(meshpp::nodeid_session_header& head
     if (header_response.block_headers.empty())
         return set_errored("blockheader response. empty response received!", throw_for_debugging_only);
 
+    pimpl->all_sync_info.sync_throughputs[header.peerid].header_response(header_response.block_headers.size(),
+                                                                         steady_clock::now() - request_time);
+
+    //  the headers verified with the previous responses
+    size_t const verified_count = sync_headers.size();
+
     sync_headers.insert(sync_headers.end(),
-                        header_response.block_headers.begin(),
-                        header_response.block_headers.end());
+                        std::make_move_iterator(header_response.block_headers.begin()),
+                        std::make_move_iterator(header_response.block_headers.end()));
 
     //  sync_headers.front() has the highest index
     if (sync_headers.front() != promised_header)
@@ -473,9 +483,29 @@ void session_action_header::process_response(meshpp::nodeid_session_header& head
     if(system_clock::from_time_t(sync_headers.front().time_signed.tm) > system_clock::now() + chrono::seconds(NODES_TIME_SHIFT))
         return set_errored("blockheader response. block from future received!", throw_for_debugging_only);
 
-    if (check_headers_vector(sync_headers))
+    //  check the links of the new headers only, including the link to
+    //  the last verified one, so the whole chain is checked once
+    if (check_headers_vector(sync_headers, verified_count > 0 ? verified_count - 1 : 0))
         return set_errored("blockheader response. wrong data in response!", throw_for_debugging_only);
 
+    //  check the consensus constants along the new headers right away,
+    //  overlapping the verified ones, so that a bad fork is rejected
+    //  before the common block is found and any block is downloaded
+    {
+        vector<pair<uint64_t, uint64_t>> delta_vector;
+        size_t index_end = verified_count > 2 * DELTA_STEP ? verified_count - 2 * DELTA_STEP : 0;
+        delta_vector.reserve(sync_headers.size() - index_end);
+
+        for (size_t index = sync_headers.size(); index > index_end; --index)
+            delta_vector.push_back(std::make_pair(sync_headers[index - 1].delta, sync_headers[index - 1].c_const));
+
+        string check_delta_vector_error;
+        check_delta_vector(delta_vector, check_delta_vector_error);
+
+        if (false == check_delta_vector_error.empty())
+            return set_errored(check_delta_vector_error, throw_for_debugging_only);
+    }
+
     // find last common header
     uint64_t lcb_index = 0;
     bool lcb_found = false;
@@ -546,7 +576,8 @@ void session_action_header::process_response(meshpp::nodeid_session_header& head
     else
     {
         block_index_from = sync_headers.back().block_number - 1;
-        block_index_to = block_index_from > HEADER_TR_LENGTH ? block_index_from - HEADER_TR_LENGTH : 0;
+        //  _initiate will narrow this down to the peer batch
+        block_index_to = 0;
 
         // request more headers
         _initiate(header, false);
@@ -561,10 +592,13 @@ void session_action_header::set_errored(string const& message, bool throw_for_de
 }
 
 //  this has opposite bool logic - true means error :)
-bool session_action_header::check_headers_vector(std::vector<BlockchainMessage::BlockHeaderExtended> const& header_vector)
+bool session_action_header::check_headers_vector(std::vector<BlockchainMessage::BlockHeaderExtended> const& header_vector,
+                                                 size_t index_from)
 {
+    assert(index_from < header_vector.size());
+
     bool t = false;
-    auto it = header_vector.begin();
+    auto it = header_vector.begin() + index_from;
     for (++it; !t && it != header_vector.end(); ++it)
         t = check_headers(*(it - 1), *it);
 
@@ -584,6 +618,8 @@ session_action_block::session_action_block(detail::node_internals& impl, reason
 
 session_action_block::~session_action_block()
 {
+    pimpl->all_sync_info.compact_block_peerid.clear();
+    pimpl->all_sync_info.parallel_download.stop();
     pimpl->all_sync_info.blockchain_sync_in_progress = false;
 }
 
@@ -593,12 +629,121 @@ void session_action_block::initiate(meshpp::nodeid_session_header& header)
     //  this assert means that the current session must have session_action_p2pconnections
 
     sync_headers = std::move(pimpl->all_sync_info.headers_actions_data[header.peerid].headers);
-    BlockchainRequest blockchain_request;
-    blockchain_request.blocks_from = sync_headers.back().block_number;
-    blockchain_request.blocks_to = sync_headers.front().block_number;
+    pimpl->all_sync_info.parallel_download.start(header.peerid, sync_headers);
 
-    pimpl->m_ptr_p2p_socket->send(header.peerid, beltpp::packet(blockchain_request));
     expected_next_package_type = BlockchainMessage::BlockchainResponse::rtt;
+    request_blocks(header, sync_headers.back().block_number);
+}
+
+void session_action_block::request_blocks(meshpp::nodeid_session_header& header, uint64_t block_number)
+{
+    //  ask no more than the batch adapted for this peer
+    uint64_t block_batch = pimpl->all_sync_info.sync_throughputs[header.peerid].block_batch;
+
+    auto& parallel_download = pimpl->all_sync_info.parallel_download;
+    parallel_download.main_position(block_number, block_batch);
+
+    //  take the blocks other peers have already brought, if any
+    auto prefetched_blocks = parallel_download.take(block_number, BLOCK_INSERT_LENGTH);
+    if (false == prefetched_blocks.empty())
+    {
+        BlockchainResponse blockchain_response;
+        blockchain_response.signed_blocks = std::move(prefetched_blocks);
+
+        request_time = steady_clock::time_point();
+        return process_response(header, std::move(blockchain_response));
+    }
+
+    //  a single new block is most likely made of transactions
+    //  already sitting in own pool, so ask for its compact form
+    if (block_number == sync_headers.front().block_number &&
+        pimpl->m_transaction_pool.length() > 0 &&
+        0 == pimpl->all_sync_info.full_block_peerids.count(header.peerid))
+    {
+        CompactBlockRequest compact_block_request;
+        compact_block_request.block_number = block_number;
+
+        expected_next_package_type = CompactBlock::rtt;
+        request_time = steady_clock::time_point();
+        pimpl->m_p2p_send_queue.send(header.peerid, beltpp::packet(compact_block_request), send_queue::blocks);
+
+        //  peers before compact blocks do not answer, block_worker
+        //  gives up on the request when the deadline passes
+        pimpl->all_sync_info.compact_block_peerid = header.peerid;
+        pimpl->all_sync_info.compact_block_deadline = steady_clock::now() +
+                                                      chrono::milliseconds(COMPACT_BLOCK_TIMEOUT);
+
+        return;
+    }
+
+    request_full_blocks(header, block_number);
+}
+
+void session_action_block::request_full_blocks(meshpp::nodeid_session_header& header, uint64_t block_number)
+{
+    uint64_t block_batch = pimpl->all_sync_info.sync_throughputs[header.peerid].block_batch;
+
+    BlockchainRequest blockchain_request;
+    blockchain_request.blocks_from = block_number;
+    blockchain_request.blocks_to = std::min(sync_headers.front().block_number,
+                                            block_number + block_batch - 1);
+
+    expected_next_package_type = BlockchainResponse::rtt;
+    request_time = steady_clock::now();
+    pimpl->m_p2p_send_queue.send(header.peerid, beltpp::packet(blockchain_request), send_queue::blocks);
+}
+
+void session_action_block::process_compact_block(meshpp::nodeid_session_header& header)
+{
+    SignedBlock signed_block;
+    signed_block.authorization = std::move(compact_block.authorization);
+    signed_block.block_details.header = std::move(compact_block.header);
+    signed_block.block_details.rewards = std::move(compact_block.rewards);
+    signed_block.block_details.signed_transactions = std::move(compact_transactions);
+
+    uint64_t block_number = signed_block.block_details.header.block_number;
+    size_t missing_count = compact_missing.size();
+
+    compact_block = CompactBlock();
+    compact_transactions.clear();
+    compact_missing.clear();
+
+    //  the peer may have sent something that does not add up,
+    //  the full block is still the way to get it then
+    if (sync_headers.front().block_hash != meshpp::hash(signed_block.block_details.to_string()))
+        return request_full_blocks(header, block_number);
+
+    pimpl->writeln_node(log_code() + " block " + std::to_string(block_number) + " - " +
+                        signed_block.authorization.address +
+                        " [compact, " + std::to_string(missing_count) + " missing]");
+
+    BlockchainResponse blockchain_response;
+    blockchain_response.signed_blocks.push_back(std::move(signed_block));
+
+    process_response(header, std::move(blockchain_response));
+}
+
+string session_action_block::log_code() const
+{
+    string s_code;
+
+    switch (m_reason.v)
+    {
+    case reason::safe_better:
+        s_code = "[sf]";
+        break;
+    case reason::safe_revert:
+        s_code = "[sf,rv]";
+        break;
+    case reason::unsafe_better:
+        s_code = "[unsf,btr][" + std::to_string(m_reason.poll_participants) + "][" + std::to_string(m_reason.poll_participants_with_stake) + "]";
+        break;
+    case reason::unsafe_best:
+        s_code = "[unsf,bst][" + std::to_string(m_reason.poll_participants) + "][" + std::to_string(m_reason.poll_participants_with_stake) + "]";
+        break;
+    }
+
+    return s_code;
 }
 
 bool session_action_block::process(beltpp::packet&& package, meshpp::nodeid_session_header& header)
@@ -627,40 +772,97 @@ bool session_action_block::process(beltpp::packet&& package, meshpp::nodeid_sess
                 temp_from = front.header.block_number;
                 temp_to = back.header.block_number;
 
-                string s_code;
-
-                switch (m_reason.v)
-                {
-                case reason::safe_better:
-                    s_code = "[sf]";
-                    break;
-                case reason::safe_revert:
-                    s_code = "[sf,rv]";
-                    break;
-                case reason::unsafe_better:
-                    s_code = "[unsf,btr][" + std::to_string(m_reason.poll_participants) + "][" + std::to_string(m_reason.poll_participants_with_stake) + "]";
-                    break;
-                case reason::unsafe_best:
-                    s_code = "[unsf,bst][" + std::to_string(m_reason.poll_participants) + "][" + std::to_string(m_reason.poll_participants_with_stake) + "]";
-                    break;
-                }
+                string s_code = log_code();
+
+                auto const& throughput = pimpl->all_sync_info.sync_throughputs[header.peerid];
+                string s_throughput = " [" + std::to_string(throughput.block_bytes_per_second / 1024) + "KB/s]";
 
                 if(temp_from == temp_to)
                     //pimpl->writeln_node("processing block " + std::to_string(temp_from) +" from " + detail::peer_short_names(peerid));
-                    pimpl->writeln_node(s_code + " block " + std::to_string(temp_from) + " - " + blockchain_response.signed_blocks.back().authorization.address);
+                    pimpl->writeln_node(s_code + " block " + std::to_string(temp_from) + " - " + blockchain_response.signed_blocks.back().authorization.address + s_throughput);
                 else
                     pimpl->writeln_node(s_code + " blocks [" + std::to_string(temp_from) +
-                                        "," + std::to_string(temp_to) + "]" + " - " + blockchain_response.signed_blocks.back().authorization.address);
+                                        "," + std::to_string(temp_to) + "]" + " - " + blockchain_response.signed_blocks.back().authorization.address + s_throughput);
             }
 
             process_response(header, std::move(blockchain_response));
             break;
         }
+        case CompactBlock::rtt:
+        {
+            std::move(package).get(compact_block);
+            pimpl->all_sync_info.compact_block_peerid.clear();
+
+            uint64_t block_number = sync_headers.front().block_number;
+            if (compact_block.header.block_number != block_number)
+            {
+                set_errored("compact block. wrong block number!", true);
+                break;
+            }
+            if (compact_block.transaction_hashes.size() > BLOCK_MAX_TRANSACTIONS)
+            {
+                set_errored("compact block. block max transactions count!", true);
+                break;
+            }
+
+            compact_transactions.resize(compact_block.transaction_hashes.size());
+            compact_missing.clear();
+            for (size_t index = 0; index != compact_block.transaction_hashes.size(); ++index)
+            {
+                size_t pool_index;
+                if (pimpl->m_transaction_pool.find(compact_block.transaction_hashes[index], pool_index))
+                    compact_transactions[index] = pimpl->m_transaction_pool.at(pool_index);
+                else
+                    compact_missing.push_back(index);
+            }
+
+            if (compact_missing.empty())
+                process_compact_block(header);
+            else
+            {
+                BlockTransactionsRequest block_transactions_request;
+                block_transactions_request.block_number = block_number;
+                block_transactions_request.indexes = compact_missing;
+
+                expected_next_package_type = BlockTransactions::rtt;
+                pimpl->m_p2p_send_queue.send(header.peerid, beltpp::packet(block_transactions_request), send_queue::blocks);
+            }
+            break;
+        }
+        case BlockTransactions::rtt:
+        {
+            BlockTransactions block_transactions;
+            std::move(package).get(block_transactions);
+
+            if (block_transactions.block_number != compact_block.header.block_number ||
+                block_transactions.signed_transactions.size() != compact_missing.size())
+            {
+                set_errored("block transactions. unexpected response!", true);
+                break;
+            }
+
+            for (size_t index = 0; index != compact_missing.size(); ++index)
+                compact_transactions[compact_missing[index]] =
+                        std::move(block_transactions.signed_transactions[index]);
+
+            process_compact_block(header);
+            break;
+        }
         default:
             assert(false);
             break;
         }
     }
+    else if (expected_next_package_type == CompactBlock::rtt &&
+             package.type() == RemoteError::rtt)
+    {
+        //  the peer did not understand the request or block_worker gave up
+        //  on it, either way continue with the full block from this peer
+        pimpl->all_sync_info.compact_block_peerid.clear();
+        pimpl->all_sync_info.full_block_peerids.insert(header.peerid);
+
+        request_full_blocks(header, sync_headers.front().block_number);
+    }
     else
     {
         code = false;
@@ -675,28 +877,67 @@ bool session_action_block::permanent() const
 }
 
 void session_action_block::process_request(beltpp::isocket::peer_id const& peerid,
-                                           BlockchainMessage::BlockchainRequest const& blockchain_request,
+                                           BlockchainMessage::CompactBlockRequest const& compact_block_request,
                                            publiqpp::detail::node_internals& impl)
 {
-    // blocks are always requested in regular order
-
     uint64_t number = impl.m_blockchain.length() - 1;
-    uint64_t from = number < blockchain_request.blocks_from ? number : blockchain_request.blocks_from;
+    number = number < compact_block_request.block_number ? number : compact_block_request.block_number;
+
+    SignedBlock const& signed_block = impl.m_blockchain.at(number);
+
+    CompactBlock compact_block;
+    compact_block.header = signed_block.block_details.header;
+    compact_block.rewards = signed_block.block_details.rewards;
+    compact_block.authorization = signed_block.authorization;
+
+    for (auto const& signed_transaction : signed_block.block_details.signed_transactions)
+        compact_block.transaction_hashes.push_back(meshpp::hash(signed_transaction.to_string()));
 
-    uint64_t to = blockchain_request.blocks_to;
-    to = to < from ? from : to;
-    to = to > from + BLOCK_TR_LENGTH ? from + BLOCK_TR_LENGTH : to;
-    to = to > number ? number : to;
+    impl.m_p2p_send_queue.send(peerid, beltpp::packet(std::move(compact_block)), send_queue::blocks);
+}
+
+void session_action_block::process_request(beltpp::isocket::peer_id const& peerid,
+                                           BlockchainMessage::BlockTransactionsRequest const& block_transactions_request,
+                                           publiqpp::detail::node_internals& impl)
+{
+    if (block_transactions_request.block_number >= impl.m_blockchain.length())
+        throw wrong_request_exception("block transactions request. block is not known!");
+
+    SignedBlock const& signed_block = impl.m_blockchain.at(block_transactions_request.block_number);
+    auto const& signed_transactions = signed_block.block_details.signed_transactions;
+
+    BlockTransactions block_transactions;
+    block_transactions.block_number = block_transactions_request.block_number;
 
-    BlockchainResponse chain_response;
-    for (auto i = from; i <= to; ++i)
+    for (auto index : block_transactions_request.indexes)
     {
-        SignedBlock const& signed_block = impl.m_blockchain.at(i);
+        if (index >= signed_transactions.size())
+            throw wrong_request_exception("block transactions request. wrong transaction index!");
 
-        chain_response.signed_blocks.push_back(std::move(signed_block));
+        block_transactions.signed_transactions.push_back(signed_transactions[index]);
     }
 
-    impl.m_ptr_p2p_socket->send(peerid, beltpp::packet(chain_response));
+    impl.m_p2p_send_queue.send(peerid, beltpp::packet(std::move(block_transactions)), send_queue::blocks);
+}
+
+void session_action_block::process_request(beltpp::isocket::peer_id const& peerid,
+                                           BlockchainMessage::BlockchainRequest const& blockchain_request,
+                                           publiqpp::detail::node_internals& impl)
+{
+    //  the block server answers on its own thread,
+    //  the node loop sends the responses it has ready
+    BlockchainRequest request = blockchain_request;
+
+    //  the peer does not take what is already queued for it, so give less
+    if (impl.m_p2p_send_queue.congested(peerid))
+        request.blocks_to = request.blocks_from;
+
+    if (false == impl.m_block_server.request(peerid, request))
+    {
+        RemoteError remote_error;
+        remote_error.message = "too many blocks requests waiting";
+        impl.m_p2p_send_queue.send(peerid, beltpp::packet(std::move(remote_error)), send_queue::blocks);
+    }
 }
 
 void session_action_block::process_response(meshpp::nodeid_session_header& header,
@@ -739,10 +980,14 @@ void session_action_block::process_response(meshpp::nodeid_session_header& heade
     if (header_it->prev_hash != prev_block_hash)
         return set_errored("blockchain response. previous hash!", throw_for_debugging_only);
 
+    auto const elapsed = steady_clock::now() - request_time;
+    size_t received_bytes = 0;
+
     for (auto& block_item : blockchain_response.signed_blocks)
     {
         Block& block = block_item.block_details;
         string block_to_string = block.to_string();
+        received_bytes += block_to_string.size();
 
         if(block.signed_transactions.size() > BLOCK_MAX_TRANSACTIONS)
             return set_errored("blockchain response. block max transactions count!", throw_for_debugging_only);
@@ -774,15 +1019,17 @@ void session_action_block::process_response(meshpp::nodeid_session_header& heade
         sync_blocks.push_back(std::move(block_item));
     }
 
+    //  prefetched blocks did not come with this request
+    if (request_time != steady_clock::time_point())
+        pimpl->all_sync_info.sync_throughputs[header.peerid].block_response(blockchain_response.signed_blocks.size(),
+                                                                            received_bytes,
+                                                                            elapsed);
+
     // request new chain if needed
     if (sync_blocks.size() < BLOCK_INSERT_LENGTH &&
         sync_blocks.size() < sync_headers.size())
     {
-        BlockchainRequest blockchain_request;
-        blockchain_request.blocks_from = header_it->block_number;
-        blockchain_request.blocks_to = sync_headers.begin()->block_number;
-
-        pimpl->m_ptr_p2p_socket->send(header.peerid, beltpp::packet(blockchain_request));
+        request_blocks(header, header_it->block_number);
 
         return; // will wait for new chain
     }
@@ -847,23 +1094,29 @@ void session_action_block::process_response(meshpp::nodeid_session_header& heade
     {
         SignedBlock const& signed_block = pimpl->m_blockchain.at(index);
         pimpl->m_blockchain.remove_last_block();
+        pimpl->m_block_server.removed();
         pimpl->m_action_log.revert();
 
         Block const& block = signed_block.block_details;
 
-        map<string, map<string, uint64_t>> unit_uri_view_counts;
-        map<string, coin> unit_sponsor_applied;
-        // verify block rewards before reverting, this also reclaims advertisement coins
-        if (check_rewards(block,
-                          signed_block.authorization.address,
-                          rewards_type::revert,
-                          *pimpl,
-                          unit_uri_view_counts,
-                          unit_sponsor_applied))
-            return set_errored("block response - " + std::to_string(block.header.block_number) + ". block rewards reverting error!", throw_for_debugging_only);
-
-        B_UNUSED(unit_uri_view_counts);
-        B_UNUSED(unit_sponsor_applied);
+        // restore the sponsored usage kept when the block was applied,
+        // for older blocks recompute and verify the rewards instead
+        if (false == pimpl->m_documents.sponsored_undo_replay(block.header.block_number))
+        {
+            map<string, map<string, uint64_t>> unit_uri_view_counts;
+            map<string, coin> unit_sponsor_applied;
+            // verify block rewards before reverting, this also reclaims advertisement coins
+            if (check_rewards(block,
+                              signed_block.authorization.address,
+                              rewards_type::revert,
+                              *pimpl,
+                              unit_uri_view_counts,
+                              unit_sponsor_applied))
+                return set_errored("block response - " + std::to_string(block.header.block_number) + ". block rewards reverting error!", throw_for_debugging_only);
+
+            B_UNUSED(unit_uri_view_counts);
+            B_UNUSED(unit_sponsor_applied);
+        }
 
         // decrease all reward amounts from balances and revert reward
         for (auto it = block.rewards.crbegin(); it != block.rewards.crend(); ++it)
@@ -1018,11 +1271,7 @@ void session_action_block::process_response(meshpp::nodeid_session_header& heade
         sync_headers.resize(sync_headers.size() - sync_blocks.size());
         sync_blocks.clear();
 
-        BlockchainRequest blockchain_request;
-        blockchain_request.blocks_from = sync_headers.back().block_number;
-        blockchain_request.blocks_to = sync_headers.front().block_number;
-
-        pimpl->m_ptr_p2p_socket->send(header.peerid, beltpp::packet(blockchain_request));
+        request_blocks(header, sync_headers.back().block_number);
     }
     else
     {
@@ -1042,6 +1291,104 @@ void session_action_block::set_errored(string const& message, bool throw_for_deb
     errored = true;
 }
 
+// --------------------------- session_action_block_range ---------------------------
+
+session_action_block_range::session_action_block_range(detail::node_internals& impl,
+                                                       string const& _peerid,
+                                                       uint64_t _block_number_from,
+                                                       uint64_t _block_number_to)
+    : session_action<meshpp::nodeid_session_header>()
+    , pimpl(&impl)
+    , peerid(_peerid)
+    , block_number_from(_block_number_from)
+    , block_number_to(_block_number_to)
+{}
+
+session_action_block_range::~session_action_block_range()
+{
+    pimpl->all_sync_info.parallel_download.release(peerid);
+}
+
+void session_action_block_range::initiate(meshpp::nodeid_session_header& header)
+{
+    BlockchainRequest blockchain_request;
+    blockchain_request.blocks_from = block_number_from;
+    blockchain_request.blocks_to = block_number_to;
+
+    request_time = steady_clock::now();
+    pimpl->m_p2p_send_queue.send(header.peerid, beltpp::packet(blockchain_request), send_queue::blocks);
+    expected_next_package_type = BlockchainMessage::BlockchainResponse::rtt;
+}
+
+bool session_action_block_range::process(beltpp::packet&& package, meshpp::nodeid_session_header& header)
+{
+    bool code = true;
+
+    if (expected_next_package_type == package.type() &&
+        expected_next_package_type != size_t(-1))
+    {
+        switch (package.type())
+        {
+        case BlockchainResponse::rtt:
+        {
+            BlockchainResponse blockchain_response;
+            std::move(package).get(blockchain_response);
+
+            auto const elapsed = steady_clock::now() - request_time;
+            auto& parallel_download = pimpl->all_sync_info.parallel_download;
+
+            if (blockchain_response.signed_blocks.empty())
+                throw wrong_data_exception("blockchain range response. empty response received!");
+
+            //  only the blocks matching the synced headers are kept,
+            //  the block session validates them fully when consuming
+            size_t received_bytes = 0;
+            uint64_t block_number = block_number_from;
+            for (auto const& signed_block : blockchain_response.signed_blocks)
+            {
+                if (signed_block.block_details.header.block_number != block_number ||
+                    block_number > block_number_to)
+                    throw wrong_data_exception("blockchain range response. wrong block number!");
+
+                string block_to_string = signed_block.block_details.to_string();
+                received_bytes += block_to_string.size();
+
+                string block_hash = parallel_download.block_hash(block_number);
+                if (false == block_hash.empty() &&
+                    block_hash != meshpp::hash(block_to_string))
+                    throw wrong_data_exception("blockchain range response. block hash!");
+
+                ++block_number;
+            }
+
+            pimpl->all_sync_info.sync_throughputs[header.peerid].block_response(blockchain_response.signed_blocks.size(),
+                                                                                received_bytes,
+                                                                                elapsed);
+
+            parallel_download.deliver(std::move(blockchain_response.signed_blocks));
+
+            completed = true;
+            expected_next_package_type = size_t(-1);
+            break;
+        }
+        default:
+            assert(false);
+            break;
+        }
+    }
+    else
+    {
+        code = false;
+    }
+
+    return code;
+}
+
+bool session_action_block_range::permanent() const
+{
+    return true;
+}
+
 // --------------------------- session_action_request_file ---------------------------
 
 session_action_request_file::session_action_request_file(string const& _file_uri,
@@ -1052,6 +1399,9 @@ session_action_request_file::session_action_request_file(string const& _file_uri
     , pimpl(&impl)
     , file_uri(_file_uri)
     , nodeid(_nodeid)
+    , storage_file()
+    , total_size(0)
+    , chunked(true)
 {}
 
 session_action_request_file::~session_action_request_file()
@@ -1067,9 +1417,34 @@ void session_action_request_file::initiate(meshpp::nodeid_session_header& header
 #endif
     pimpl->m_storage_controller.initiate(file_uri, nodeid, storage_controller::check);
 
+    auto it_whole_file = pimpl->m_whole_file_channels.find(nodeid);
+    if (it_whole_file != pimpl->m_whole_file_channels.end())
+    {
+        if (steady_clock::now() < it_whole_file->second)
+        {
+            request_whole_file(header);
+            return;
+        }
+
+        pimpl->m_whole_file_channels.erase(it_whole_file);
+    }
+
+    //  the file is transferred in chunks, so the packet size is limited by chunk size
+    //  escaped binary data can take up to 6 bytes per byte
+    beltpp::detail::session_special_data& ssd =
+            pimpl->m_ptr_rpc_socket->session_data(header.peerid);
+    ssd.parser_unrecognized_limit = 6 * STORAGE_FILE_CHUNK_SIZE + 1024;
+
+    request_chunk(header);
+}
+
+void session_action_request_file::request_whole_file(meshpp::nodeid_session_header& header)
+{
+    chunked = false;
+
     beltpp::detail::session_special_data& ssd =
             pimpl->m_ptr_rpc_socket->session_data(header.peerid);
-    ssd.parser_unrecognized_limit = 1024 * 1024 * 30;
+    ssd.parser_unrecognized_limit = 6 * STORAGE_MAX_FILE_SIZE + 1024;
 
     StorageFileRequest msg;
     msg.uri = file_uri;
@@ -1078,6 +1453,17 @@ void session_action_request_file::initiate(meshpp::nodeid_session_header& header
     expected_next_package_type = BlockchainMessage::StorageFile::rtt;
 }
 
+void session_action_request_file::request_chunk(meshpp::nodeid_session_header& header)
+{
+    StorageFileChunkRequest msg;
+    msg.uri = file_uri;
+    msg.offset = storage_file.data.length();
+    msg.max_length = STORAGE_FILE_CHUNK_SIZE;
+    pimpl->m_ptr_rpc_socket->send(header.peerid, beltpp::packet(std::move(msg)));
+
+    expected_next_package_type = BlockchainMessage::StorageFileChunk::rtt;
+}
+
 bool session_action_request_file::process(beltpp::packet&& package, meshpp::nodeid_session_header& header)
 {
     bool code = true;
@@ -1089,92 +1475,51 @@ bool session_action_request_file::process(beltpp::packet&& package, meshpp::node
     {
         switch (package.type())
         {
-        case BlockchainMessage::StorageFile::rtt:
+        case BlockchainMessage::StorageFileChunk::rtt:
         {
-#ifdef EXTRA_LOGGING
-            pimpl->writeln_node(file_uri + " processing");
-#endif
-            BlockchainMessage::StorageFile storage_file;
-            std::move(package).get(storage_file);
-
-            if (file_uri != meshpp::hash(storage_file.data))
+            BlockchainMessage::StorageFileChunk chunk;
+            std::move(package).get(chunk);
+
+            if (chunk.uri != file_uri ||
+                chunk.offset != storage_file.data.length() ||
+                chunk.total_size > STORAGE_MAX_FILE_SIZE ||
+                (storage_file.data.empty() == false && chunk.total_size != total_size) ||
+                chunk.offset + chunk.data.length() > chunk.total_size ||
+                (chunk.data.empty() && chunk.offset != chunk.total_size))
             {
 #ifdef EXTRA_LOGGING
-                pimpl->writeln_node(file_uri + " verification failed");
+                pimpl->writeln_node(file_uri + " wrong chunk received");
 #endif
                 errored = true;
                 break;
             }
 
-            auto& impl = *pimpl;
-            auto nodeid_local = nodeid;
-            auto file_uri_local = file_uri;
-
-            vector<unique_ptr<meshpp::session_action<meshpp::session_header>>> actions;
-            actions.emplace_back(new session_action_save_file(impl,
-                                                              std::move(storage_file),
-                                                              [&impl, nodeid_local, file_uri_local, header](beltpp::packet&& package)
+            if (storage_file.data.empty())
             {
-                bool stored = false;
-
-                impl.m_storage_controller.initiate(file_uri_local, nodeid_local, storage_controller::revert);
-
-                if (package.type() == StorageFileAddress::rtt)
-                {
-#ifdef EXTRA_LOGGING
-                    impl.writeln_node(file_uri_local + " saved");
-#endif
-                    StorageFileAddress* pfile_address;
-                    package.get(pfile_address);
-
-                    assert(pfile_address->uri == file_uri_local);
-                    if (pfile_address->uri != file_uri_local)
-                        throw std::logic_error("pfile_address->uri != file_uri_local");
-
-                    stored = true;
-                }
-                else if (package.type() == UriError::rtt)
-                {
-                    UriError* puri_error;
-                    package.get(puri_error);
-
-                    if (puri_error->uri_problem_type == UriProblemType::duplicate)
-                        stored = true;
-                }
-
-                if (stored)
-                {
-#ifdef EXTRA_LOGGING
-                    beltpp::on_failure guard([&impl, file_uri_local]{impl.writeln_node(file_uri_local + " flew");});
-#endif
-                    if (false == impl.m_documents.storage_has_uri(file_uri_local, impl.m_pb_key.to_string()))
-                        broadcast_storage_update(impl, file_uri_local, UpdateType::store);
-#ifdef EXTRA_LOGGING
-                    guard.dismiss();
-                    
-                    impl.writeln_node(file_uri_local + " session_action_save_file callback calling pop");
-#endif
-                    impl.m_storage_controller.pop(file_uri_local, nodeid_local);
-                }
-#ifdef EXTRA_LOGGING
-                else
-                {
-                    impl.writeln_node(file_uri_local + " - " + package.to_string());
-                }
-#endif
-            }));
+                total_size = chunk.total_size;
+                storage_file.mime_type = chunk.mime_type;
+                storage_file.data.reserve(total_size);
+            }
 
-            meshpp::session_header slave_header;
-            slave_header.peerid = "slave";
-            pimpl->m_sessions.add(slave_header,
-                                  std::move(actions),
-                                  chrono::minutes(1));
+            //  the chunks only limit the packet size, the file is still
+            //  gathered here as a whole, because its uri is the hash of
+            //  the whole data and can be checked only in one go
+            storage_file.data.append(chunk.data);
 
-            need_to_revert_initiate = false;
+            if (storage_file.data.length() < total_size)
+            {
+                request_chunk(header);
+                break;
+            }
 
-            completed = true;
-            expected_next_package_type = size_t(-1);
+            save_file(header);
+            break;
+        }
+        case BlockchainMessage::StorageFile::rtt:
+        {
+            std::move(package).get(storage_file);
 
+            save_file(header);
             break;
         }
         default:
@@ -1182,6 +1527,27 @@ bool session_action_request_file::process(beltpp::packet&& package, meshpp::node
             break;
         }
     }
+    else if (chunked &&
+             storage_file.data.empty() &&
+             (package.type() == RemoteError::rtt ||
+              package.type() == beltpp::isocket_drop::rtt ||
+              package.type() == beltpp::isocket_protocol_error::rtt))
+    {
+        //  channels running before the chunked transfer do not know
+        //  StorageFileChunkRequest and drop the connection on it,
+        //  but so can a channel that just went down, ask for whole files
+        //  only for a while and then try the chunks again
+#ifdef EXTRA_LOGGING
+        pimpl->writeln_node(nodeid + " does not serve file chunks");
+#endif
+        pimpl->m_whole_file_channels[nodeid] =
+                steady_clock::now() + chrono::seconds(STORAGE_WHOLE_FILE_CHANNEL_SECONDS);
+
+        if (package.type() == RemoteError::rtt)
+            request_whole_file(header);
+        else
+            code = false;
+    }
     else if (package.type() == UriError::rtt)
     {
         UriError* msg;
@@ -1209,6 +1575,94 @@ bool session_action_request_file::process(beltpp::packet&& package, meshpp::node
     return code;
 }
 
+void session_action_request_file::save_file(meshpp::nodeid_session_header& header)
+{
+#ifdef EXTRA_LOGGING
+    pimpl->writeln_node(file_uri + " processing");
+#endif
+    //  the only place the received data is hashed,
+    //  the slave will store it under this verified uri
+    if (file_uri != meshpp::hash(storage_file.data))
+    {
+#ifdef EXTRA_LOGGING
+        pimpl->writeln_node(file_uri + " verification failed");
+#endif
+        errored = true;
+        return;
+    }
+
+    auto& impl = *pimpl;
+    auto nodeid_local = nodeid;
+    auto file_uri_local = file_uri;
+
+    vector<unique_ptr<meshpp::session_action<meshpp::session_header>>> actions;
+    actions.emplace_back(new session_action_save_file(impl,
+                                                      std::move(storage_file),
+                                                      [&impl, nodeid_local, file_uri_local, header](beltpp::packet&& package)
+    {
+        bool stored = false;
+
+        impl.m_storage_controller.initiate(file_uri_local, nodeid_local, storage_controller::revert);
+
+        if (package.type() == StorageFileAddress::rtt)
+        {
+#ifdef EXTRA_LOGGING
+            impl.writeln_node(file_uri_local + " saved");
+#endif
+            StorageFileAddress* pfile_address;
+            package.get(pfile_address);
+
+            assert(pfile_address->uri == file_uri_local);
+            if (pfile_address->uri != file_uri_local)
+                throw std::logic_error("pfile_address->uri != file_uri_local");
+
+            stored = true;
+        }
+        else if (package.type() == UriError::rtt)
+        {
+            UriError* puri_error;
+            package.get(puri_error);
+
+            if (puri_error->uri_problem_type == UriProblemType::duplicate)
+                stored = true;
+        }
+
+        if (stored)
+        {
+#ifdef EXTRA_LOGGING
+            beltpp::on_failure guard([&impl, file_uri_local]{impl.writeln_node(file_uri_local + " flew");});
+#endif
+            if (false == impl.m_documents.storage_has_uri(file_uri_local, impl.m_pb_key.to_string()))
+                broadcast_storage_update(impl, file_uri_local, UpdateType::store);
+#ifdef EXTRA_LOGGING
+            guard.dismiss();
+            
+            impl.writeln_node(file_uri_local + " session_action_save_file callback calling pop");
+#endif
+            impl.m_storage_controller.pop(file_uri_local, nodeid_local);
+        }
+#ifdef EXTRA_LOGGING
+        else
+        {
+            impl.writeln_node(file_uri_local + " - " + package.to_string());
+        }
+#endif
+    },
+                                                      file_uri,
+                                                      nodeid));
+
+    meshpp::session_header slave_header;
+    slave_header.peerid = "slave";
+    pimpl->m_sessions.add(slave_header,
+                          std::move(actions),
+                          chrono::minutes(1));
+
+    need_to_revert_initiate = false;
+
+    completed = true;
+    expected_next_package_type = size_t(-1);
+}
+
 bool session_action_request_file::permanent() const
 {
     return false;
@@ -1218,11 +1672,15 @@ bool session_action_request_file::permanent() const
 
 session_action_save_file::session_action_save_file(detail::node_internals& impl,
                                                    StorageFile&& _file,
-                                                   std::function<void(beltpp::packet&&)> const& _callback)
+                                                   std::function<void(beltpp::packet&&)> const& _callback,
+                                                   string const& _verified_uri/* = string()*/,
+                                                   string const& _channel_address/* = string()*/)
     : meshpp::session_action<meshpp::session_header>()
     , pimpl(&impl)
-    , file(_file)
+    , file(std::move(_file))
     , callback(_callback)
+    , verified_uri(_verified_uri)
+    , channel_address(_channel_address)
 {}
 
 session_action_save_file::~session_action_save_file()
@@ -1251,6 +1709,8 @@ void session_action_save_file::initiate(meshpp::session_header&/* header*/)
 {
     StorageTypes::StorageFile file_ex;
     file_ex.storage_file.set(std::move(file));
+    file_ex.verified_uri = verified_uri;
+    file_ex.channel_address = channel_address;
 
     pimpl->m_slave_node->send(beltpp::packet(std::move(file_ex)));
     pimpl->m_slave_node->wake();
@@ -1452,9 +1912,19 @@ session_action_get_file_uris::~session_action_get_file_uris()
 
 void session_action_get_file_uris::initiate(meshpp::session_header&/* header*/)
 {
-    pimpl->m_slave_node->send(beltpp::packet(StorageTypes::FileUrisRequest()));
+    request_page();
+    expected_next_package_type = BlockchainMessage::FileUrisPage::rtt;
+}
+
+void session_action_get_file_uris::request_page()
+{
+    StorageTypes::FileUrisPageRequest page_request;
+    if (false == file_uris.file_uris.empty())
+        page_request.start_after = file_uris.file_uris.back();
+    page_request.max_count = STORAGE_FILE_URIS_PAGE_SIZE;
+
+    pimpl->m_slave_node->send(beltpp::packet(std::move(page_request)));
     pimpl->m_slave_node->wake();
-    expected_next_package_type = BlockchainMessage::FileUris::rtt;
 }
 
 bool session_action_get_file_uris::process(beltpp::packet&& package, meshpp::session_header&/* header*/)
@@ -1468,6 +1938,109 @@ bool session_action_get_file_uris::process(beltpp::packet&& package, meshpp::ses
     package.get(msg_container);
     auto& msg_package = msg_container->package;
 
+    if (expected_next_package_type == msg_package.type() &&
+        expected_next_package_type != size_t(-1))
+    {
+        switch (msg_package.type())
+        {
+        case BlockchainMessage::FileUrisPage::rtt:
+        {
+            BlockchainMessage::FileUrisPage msg;
+            std::move(msg_package).get(msg);
+
+            //  the full listing is collected page by page, so the slave
+            //  never has to build it in one piece
+            bool more = msg.more && false == msg.file_uris.empty();
+            for (auto& file_uri : msg.file_uris)
+                file_uris.file_uris.push_back(std::move(file_uri));
+
+            if (more)
+            {
+                request_page();
+                break;
+            }
+
+            beltpp::finally guard2([this]{ callback = std::function<void(beltpp::packet&&)>(); });
+            if (callback)
+                callback(beltpp::packet(std::move(file_uris)));
+
+            completed = true;
+            expected_next_package_type = size_t(-1);
+
+            break;
+        }
+        default:
+            assert(false);
+            break;
+        }
+    }
+    else
+        code = false;
+
+    guard.dismiss();
+
+    return code;
+}
+
+bool session_action_get_file_uris::permanent() const
+{
+    return true;
+}
+
+// --------------------------- session_action_check_file_uris ---------------------------
+
+session_action_check_file_uris::session_action_check_file_uris(detail::node_internals& impl,
+                                                               vector<string> const& _file_uris,
+                                                               std::function<void(beltpp::packet&&)> const& _callback)
+    : meshpp::session_action<meshpp::session_header>()
+    , pimpl(&impl)
+    , file_uris(_file_uris)
+    , callback(_callback)
+{}
+
+session_action_check_file_uris::~session_action_check_file_uris()
+{
+    if ((size_t(-1) != expected_next_package_type ||
+         errored) &&
+        callback)
+    {
+        BlockchainMessage::RemoteError msg;
+        msg.message = "unknown error checking the file uris " +
+                      std::to_string(expected_next_package_type) + ", " +
+                      std::to_string(errored);
+        callback(beltpp::packet(std::move(msg)));
+    }
+    else if (callback)
+    {
+#ifdef EXTRA_LOGGING
+        pimpl->writeln_node("~session_action_check_file_uris: dummy callback");
+#endif
+        assert(false == initiated);
+        callback(beltpp::packet());
+    }
+}
+
+void session_action_check_file_uris::initiate(meshpp::session_header&/* header*/)
+{
+    StorageTypes::FileUrisCheckRequest check_request;
+    check_request.file_uris = file_uris;
+
+    pimpl->m_slave_node->send(beltpp::packet(std::move(check_request)));
+    pimpl->m_slave_node->wake();
+    expected_next_package_type = BlockchainMessage::FileUris::rtt;
+}
+
+bool session_action_check_file_uris::process(beltpp::packet&& package, meshpp::session_header&/* header*/)
+{
+    bool code = true;
+    if (package.type() != StorageTypes::ContainerMessage::rtt)
+        return false;
+    beltpp::on_failure guard([this]{ errored = true; });
+
+    StorageTypes::ContainerMessage* msg_container;
+    package.get(msg_container);
+    auto& msg_package = msg_container->package;
+
     if (expected_next_package_type == msg_package.type() &&
         expected_next_package_type != size_t(-1))
     {
@@ -1500,7 +2073,122 @@ bool session_action_get_file_uris::process(beltpp::packet&& package, meshpp::ses
     return code;
 }
 
-bool session_action_get_file_uris::permanent() const
+bool session_action_check_file_uris::permanent() const
+{
+    return true;
+}
+
+// --------------------------- session_action_get_file_uris_page ---------------------------
+
+session_action_get_file_uris_page::session_action_get_file_uris_page(detail::node_internals& impl,
+                                                                     string const& _start_after,
+                                                                     uint64_t _max_count,
+                                                                     bool _stream,
+                                                                     std::function<void(beltpp::packet&&)> const& _callback)
+    : meshpp::session_action<meshpp::session_header>()
+    , pimpl(&impl)
+    , start_after(_start_after)
+    , max_count(_max_count)
+    , stream(_stream)
+    , callback(_callback)
+{}
+
+session_action_get_file_uris_page::~session_action_get_file_uris_page()
+{
+    if ((size_t(-1) != expected_next_package_type ||
+         errored) &&
+        callback)
+    {
+        BlockchainMessage::RemoteError msg;
+        msg.message = "unknown error getting the file uris page " +
+                      std::to_string(expected_next_package_type) + ", " +
+                      std::to_string(errored);
+        callback(beltpp::packet(std::move(msg)));
+    }
+    else if (callback)
+    {
+#ifdef EXTRA_LOGGING
+        pimpl->writeln_node("~session_action_get_file_uris_page: dummy callback");
+#endif
+        assert(false == initiated);
+        callback(beltpp::packet());
+    }
+}
+
+void session_action_get_file_uris_page::initiate(meshpp::session_header&/* header*/)
+{
+    request_page();
+    expected_next_package_type = BlockchainMessage::FileUrisPage::rtt;
+}
+
+void session_action_get_file_uris_page::request_page()
+{
+    StorageTypes::FileUrisPageRequest page_request;
+    page_request.start_after = start_after;
+    page_request.max_count = max_count;
+
+    pimpl->m_slave_node->send(beltpp::packet(std::move(page_request)));
+    pimpl->m_slave_node->wake();
+}
+
+bool session_action_get_file_uris_page::process(beltpp::packet&& package, meshpp::session_header&/* header*/)
+{
+    bool code = true;
+    if (package.type() != StorageTypes::ContainerMessage::rtt)
+        return false;
+    beltpp::on_failure guard([this]{ errored = true; });
+
+    StorageTypes::ContainerMessage* msg_container;
+    package.get(msg_container);
+    auto& msg_package = msg_container->package;
+
+    if (expected_next_package_type == msg_package.type() &&
+        expected_next_package_type != size_t(-1))
+    {
+        switch (msg_package.type())
+        {
+        case BlockchainMessage::FileUrisPage::rtt:
+        {
+            BlockchainMessage::FileUrisPage msg;
+            std::move(msg_package).get(msg);
+
+            //  when streaming, keep asking the slave for the pages one by one
+            //  and hand each of them over as soon as it arrives
+            if (stream &&
+                msg.more &&
+                false == msg.file_uris.empty())
+            {
+                start_after = msg.file_uris.back();
+                if (callback)
+                    callback(beltpp::packet(std::move(msg)));
+
+                request_page();
+                break;
+            }
+
+            beltpp::finally guard2([this]{ callback = std::function<void(beltpp::packet&&)>(); });
+            if (callback)
+                callback(beltpp::packet(std::move(msg)));
+
+            completed = true;
+            expected_next_package_type = size_t(-1);
+
+            break;
+        }
+        default:
+            assert(false);
+            break;
+        }
+    }
+    else
+        code = false;
+
+    guard.dismiss();
+
+    return code;
+}
+
+bool session_action_get_file_uris_page::permanent() const
 {
     return true;
 }
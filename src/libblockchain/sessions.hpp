@@ -8,6 +8,7 @@
 
 #include <vector>
 #include <string>
+#include <chrono>
 #include <functional>
 #include <unordered_set>
 
@@ -118,7 +119,8 @@ public:
     void set_errored(std::string const& message, bool throw_for_debugging_only);
 
     //  this has opposite bool logic - true means error :)
-    bool check_headers_vector(std::vector<BlockchainMessage::BlockHeaderExtended> const& header_vector);
+    bool check_headers_vector(std::vector<BlockchainMessage::BlockHeaderExtended> const& header_vector,
+                              size_t index_from);
 
     detail::node_internals* pimpl;
     uint64_t block_index_from;
@@ -126,6 +128,7 @@ public:
     BlockchainMessage::BlockHeaderExtended const promised_header;
     std::string current_peerid;
     std::vector<BlockchainMessage::BlockHeaderExtended> sync_headers;
+    std::chrono::steady_clock::time_point request_time;
 
 protected:
     void _initiate(meshpp::nodeid_session_header& header, bool first);
@@ -155,15 +158,54 @@ public:
                          BlockchainMessage::BlockchainRequest const& blockchain_request,
                          publiqpp::detail::node_internals& impl);
 
+    static
+    void process_request(beltpp::isocket::peer_id const& peerid,
+                         BlockchainMessage::CompactBlockRequest const& compact_block_request,
+                         publiqpp::detail::node_internals& impl);
+
+    static
+    void process_request(beltpp::isocket::peer_id const& peerid,
+                         BlockchainMessage::BlockTransactionsRequest const& block_transactions_request,
+                         publiqpp::detail::node_internals& impl);
+
     void process_response(meshpp::nodeid_session_header& header,
                           BlockchainMessage::BlockchainResponse&& blockchain_response);
 
     void set_errored(std::string const& message, bool throw_for_debugging_only);
 
+    void request_blocks(meshpp::nodeid_session_header& header, uint64_t block_number);
+    void request_full_blocks(meshpp::nodeid_session_header& header, uint64_t block_number);
+    void process_compact_block(meshpp::nodeid_session_header& header);
+    std::string log_code() const;
+
     detail::node_internals* pimpl;
     std::vector<BlockchainMessage::SignedBlock> sync_blocks;
     std::vector<BlockchainMessage::BlockHeaderExtended> sync_headers;
     reason m_reason;
+    std::chrono::steady_clock::time_point request_time;
+    BlockchainMessage::CompactBlock compact_block;
+    std::vector<BlockchainMessage::SignedTransaction> compact_transactions;
+    std::vector<uint64_t> compact_missing;
+};
+
+class session_action_block_range : public meshpp::session_action<meshpp::nodeid_session_header>
+{
+public:
+    session_action_block_range(detail::node_internals& impl,
+                               std::string const& peerid,
+                               uint64_t block_number_from,
+                               uint64_t block_number_to);
+    ~session_action_block_range() override;
+
+    void initiate(meshpp::nodeid_session_header& header) override;
+    bool process(beltpp::packet&& package, meshpp::nodeid_session_header& header) override;
+    bool permanent() const override;
+
+    detail::node_internals* pimpl;
+    std::string peerid;
+    uint64_t block_number_from;
+    uint64_t block_number_to;
+    std::chrono::steady_clock::time_point request_time;
 };
 
 class session_action_request_file : public meshpp::session_action<meshpp::nodeid_session_header>
@@ -178,10 +220,17 @@ public:
     bool process(beltpp::packet&& package, meshpp::nodeid_session_header& header) override;
     bool permanent() const override;
 
+    void request_chunk(meshpp::nodeid_session_header& header);
+    void request_whole_file(meshpp::nodeid_session_header& header);
+    void save_file(meshpp::nodeid_session_header& header);
+
     bool need_to_revert_initiate;
     detail::node_internals* pimpl;
     std::string const file_uri;
     std::string const nodeid;
+    BlockchainMessage::StorageFile storage_file;
+    uint64_t total_size;
+    bool chunked;
 };
 
 class session_action_save_file : public meshpp::session_action<meshpp::session_header>
@@ -189,7 +238,9 @@ class session_action_save_file : public meshpp::session_action<meshpp::session_h
 public:
     session_action_save_file(detail::node_internals& impl,
                              BlockchainMessage::StorageFile&& file,
-                             std::function<void(beltpp::packet&&)> const& callback);
+                             std::function<void(beltpp::packet&&)> const& callback,
+                             std::string const& verified_uri = std::string(),
+                             std::string const& channel_address = std::string());
     ~session_action_save_file() override;
 
     void initiate(meshpp::session_header& header) override;
@@ -199,6 +250,8 @@ public:
     detail::node_internals* pimpl;
     BlockchainMessage::StorageFile file;
     std::function<void(beltpp::packet&&)> callback;
+    std::string verified_uri;
+    std::string channel_address;
 };
 
 class session_action_delete_file : public meshpp::session_action<meshpp::session_header>
@@ -229,7 +282,50 @@ public:
     bool process(beltpp::packet&& package, meshpp::session_header& header) override;
     bool permanent() const override;
 
+    void request_page();
+
+    detail::node_internals* pimpl;
+    BlockchainMessage::FileUris file_uris;
+    std::function<void(beltpp::packet&&)> callback;
+};
+
+class session_action_check_file_uris : public meshpp::session_action<meshpp::session_header>
+{
+public:
+    session_action_check_file_uris(detail::node_internals& impl,
+                                   std::vector<std::string> const& file_uris,
+                                   std::function<void(beltpp::packet&&)> const& callback);
+    ~session_action_check_file_uris() override;
+
+    void initiate(meshpp::session_header& header) override;
+    bool process(beltpp::packet&& package, meshpp::session_header& header) override;
+    bool permanent() const override;
+
+    detail::node_internals* pimpl;
+    std::vector<std::string> file_uris;
+    std::function<void(beltpp::packet&&)> callback;
+};
+
+class session_action_get_file_uris_page : public meshpp::session_action<meshpp::session_header>
+{
+public:
+    session_action_get_file_uris_page(detail::node_internals& impl,
+                                      std::string const& start_after,
+                                      uint64_t max_count,
+                                      bool stream,
+                                      std::function<void(beltpp::packet&&)> const& callback);
+    ~session_action_get_file_uris_page() override;
+
+    void initiate(meshpp::session_header& header) override;
+    bool process(beltpp::packet&& package, meshpp::session_header& header) override;
+    bool permanent() const override;
+
+    void request_page();
+
     detail::node_internals* pimpl;
+    std::string start_after;
+    uint64_t max_count;
+    bool stream;
     std::function<void(beltpp::packet&&)> callback;
 };
 
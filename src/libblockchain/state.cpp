@@ -119,7 +119,7 @@ void state::increase_balance(string const& key, coin const& amount, state_layer
     if (amount.empty())
         return;
 
-    Coin balance = get_balance(key, state_layer::pool);
+    coin balance = get_balance(key, state_layer::pool);
     set_balance(key, balance + amount, layer);
 }
 
@@ -128,10 +128,10 @@ void state::decrease_balance(string const& key, coin const& amount, state_layer
     if (amount.empty())
         return;
 
-    Coin balance = get_balance(key, state_layer::pool);
+    coin balance = get_balance(key, state_layer::pool);
 
-    if (coin(balance) < amount)
-        throw not_enough_balance_exception(coin(balance), amount);
+    if (balance < amount)
+        throw not_enough_balance_exception(balance, amount);
 
     set_balance(key, balance - amount, layer);
 }
@@ -0,0 +1,493 @@
+#include "statistics_aggregation.hpp"
+#include "common.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+using namespace BlockchainMessage;
+
+using std::map;
+using std::multimap;
+using std::pair;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+namespace publiqpp
+{
+namespace
+{
+//  interns strings to dense ids, the rank of an id is its position
+//  in string order, so sorting by ranks keeps the std::map ordering
+class string_ids
+{
+public:
+    uint32_t id(string const& value)
+    {
+        auto insert_result = ids.insert({value, uint32_t(values.size())});
+        if (insert_result.second)
+            values.push_back(&insert_result.first->first);
+
+        return insert_result.first->second;
+    }
+
+    bool find(string const& value, uint32_t& result) const
+    {
+        auto it = ids.find(value);
+        if (it == ids.end())
+            return false;
+
+        result = it->second;
+        return true;
+    }
+
+    void rank()
+    {
+        order.resize(values.size());
+        for (uint32_t index = 0; index != order.size(); ++index)
+            order[index] = index;
+
+        std::sort(order.begin(), order.end(), [this](uint32_t first, uint32_t second)
+        {
+            return *values[first] < *values[second];
+        });
+
+        ranks.resize(order.size());
+        for (uint32_t index = 0; index != order.size(); ++index)
+            ranks[order[index]] = index;
+    }
+
+    string const& value(uint32_t id) const
+    {
+        return *values[id];
+    }
+
+    string const& ranked(uint32_t rank) const
+    {
+        return *values[order[rank]];
+    }
+
+    size_t size() const
+    {
+        return values.size();
+    }
+
+    vector<uint32_t> ranks;
+private:
+    unordered_map<string, uint32_t> ids;
+    vector<string const*> values;
+    vector<uint32_t> order;
+};
+
+class reported_item
+{
+public:
+    uint32_t channel;
+    uint32_t file;
+    uint32_t storage;
+    uint32_t unit;
+    uint64_t count;
+    size_t group;
+};
+
+//  channel reports summed by channel, file and storage
+class verified_item
+{
+public:
+    uint32_t channel;
+    uint32_t file;
+    uint32_t storage;
+    uint64_t count;
+    bool verified;
+};
+
+class unit_item
+{
+public:
+    bool resolved;
+    uint32_t owner;
+    uint64_t content_id;
+};
+
+class author_item
+{
+public:
+    uint32_t unit;
+    uint32_t file;
+    uint64_t count;
+};
+
+class content_item
+{
+public:
+    uint32_t channel;
+    uint32_t owner;
+    uint64_t content_id;
+    uint32_t unit;
+    uint32_t file;
+    uint64_t count;
+};
+
+template <typename T, typename F>
+void sort_and_merge(vector<T>& items, F key)
+{
+    std::sort(items.begin(), items.end(), [&key](T const& first, T const& second)
+    {
+        return key(first) < key(second);
+    });
+
+    auto it_to = items.begin();
+    for (auto it = items.begin(); it != items.end(); ++it)
+    {
+        if (it_to != items.begin() && key(*(it_to - 1)) == key(*it))
+            (it_to - 1)->count += it->count;
+        else
+            *it_to++ = *it;
+    }
+    items.erase(it_to, items.end());
+}
+
+//  calls f for each index in [0, count), split in contiguous ranges between
+//  the threads, f must only write the state belonging to its index
+template <typename F>
+void parallel_for(size_t count, size_t threads, F f)
+{
+    threads = std::max(size_t(1), std::min(threads, count));
+
+    vector<std::exception_ptr> errors(threads);
+    auto run = [count, threads, &f, &errors](size_t part)
+    {
+        try
+        {
+            for (size_t index = count * part / threads;
+                 index != count * (part + 1) / threads;
+                 ++index)
+                f(index);
+        }
+        catch (...)
+        {
+            errors[part] = std::current_exception();
+        }
+    };
+
+    vector<std::thread> workers;
+    for (size_t part = 1; part < threads; ++part)
+        workers.emplace_back(run, part);
+    run(0);
+
+    for (auto& worker : workers)
+        worker.join();
+
+    //  the same error as the sequential loop would stop at
+    for (auto const& error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
+}
+
+bool stat_mismatch(uint64_t first, uint64_t second)
+{
+    return std::max(first, second) > std::min(first, second) * STAT_ERROR_LIMIT;
+}
+
+void aggregate_statistics(map<string, ServiceStatistics> const& channel_provided_statistics,
+                          map<string, ServiceStatistics> const& storage_provided_statistics,
+                          statistics_lookup const& lookup,
+                          uint64_t block_number,
+                          multimap<string, pair<uint64_t, uint64_t>>& author_result,
+                          multimap<string, pair<uint64_t, uint64_t>>& channel_result,
+                          multimap<string, pair<uint64_t, uint64_t>>& storage_result,
+                          map<string, map<string, uint64_t>>& unit_uri_view_counts)
+{
+    author_result.clear();
+    channel_result.clear();
+    storage_result.clear();
+
+    unit_uri_view_counts.clear();
+
+    //  channels, storages and owners share the address ids
+    string_ids addresses, file_uris, unit_uris;
+
+    vector<reported_item> reported;
+    for (auto const& stat_item : channel_provided_statistics)
+    {
+        uint32_t channel = addresses.id(stat_item.first);
+
+        for (auto const& file_item : stat_item.second.file_items)
+        {
+            uint32_t file = file_uris.id(file_item.file_uri);
+            uint32_t unit = unit_uris.id(file_item.unit_uri);
+
+            for (auto const& count_item : file_item.count_items)
+            {
+                if (count_item.count == 0)
+                    throw std::logic_error("count_item.count == 0");
+
+                reported.push_back({channel,
+                                    file,
+                                    addresses.id(count_item.peer_address),
+                                    unit,
+                                    count_item.count,
+                                    0});
+            }
+        }
+    }
+
+    // group channel provided data to verify in comming steps
+    auto verified_key = [](verified_item const& item)
+    {
+        return std::make_tuple(item.channel, item.file, item.storage);
+    };
+
+    vector<verified_item> verified;
+    verified.reserve(reported.size());
+    for (auto const& item : reported)
+        verified.push_back({item.channel, item.file, item.storage, item.count, false});
+
+    sort_and_merge(verified, verified_key);
+
+    auto find_verified = [&verified, &verified_key](uint32_t channel, uint32_t file, uint32_t storage)
+    {
+        verified_item value{channel, file, storage, 0, false};
+        return std::lower_bound(verified.begin(), verified.end(), value,
+                                [&verified_key](verified_item const& first, verified_item const& second)
+        {
+            return verified_key(first) < verified_key(second);
+        });
+    };
+
+    for (auto& item : reported)
+        item.group = size_t(find_verified(item.channel, item.file, item.storage) - verified.begin());
+
+    // cross compare channel and storage provided data
+    // a storage only marks the items reported for it, so storages are independent
+    vector<map<string, ServiceStatistics>::const_iterator> storages;
+    for (auto it = storage_provided_statistics.begin(); it != storage_provided_statistics.end(); ++it)
+        storages.push_back(it);
+
+    parallel_for(storages.size(), lookup.threads, [&](size_t index)
+    {
+        auto const& stat_item = *storages[index];
+
+        uint32_t storage;
+        bool storage_known = addresses.find(stat_item.first, storage);
+
+        for (auto const& file_item : stat_item.second.file_items)
+        {
+            uint32_t file;
+            bool file_known = file_uris.find(file_item.file_uri, file);
+
+            for (auto const& count_item : file_item.count_items)
+            {
+                if (count_item.count == 0)
+                    throw std::logic_error("count_item.count == 0");
+
+                uint32_t channel;
+                if (false == storage_known ||
+                    false == file_known ||
+                    false == addresses.find(count_item.peer_address, channel))
+                    continue;
+
+                auto it = find_verified(channel, file, storage);
+                if (it != verified.end() &&
+                    verified_key(*it) == std::make_tuple(channel, file, storage) &&
+                    false == stat_mismatch(it->count, count_item.count))
+                    it->verified = true;
+            }
+        }
+    });
+
+    // from here on - only the cross verified reports are used
+    vector<unit_item> units(unit_uris.size(), unit_item{false, 0, 0});
+    for (auto const& item : reported)
+    {
+        if (false == verified[item.group].verified)
+            continue;
+
+        auto& unit = units[item.unit];
+        if (false == unit.resolved)
+        {
+            ContentUnit const& content_unit = lookup.get_unit(unit_uris.value(item.unit));
+            unit.owner = addresses.id(content_unit.channel_address);
+            unit.content_id = content_unit.content_id;
+            unit.resolved = true;
+        }
+    }
+
+    addresses.rank();
+    file_uris.rank();
+    unit_uris.rank();
+
+    // below everything is keyed by ranks
+    // storage views, indexed by storage
+    vector<uint64_t> storage_group(addresses.size(), 0);
+    vector<author_item> author_group;
+    vector<content_item> content_group;
+
+    for (auto const& item : reported)
+    {
+        if (false == verified[item.group].verified)
+            continue;
+
+        auto const& unit = units[item.unit];
+        uint32_t unit_rank = unit_uris.ranks[item.unit];
+        uint32_t file_rank = file_uris.ranks[item.file];
+
+        storage_group[addresses.ranks[item.storage]] += item.count;
+        author_group.push_back({unit_rank, file_rank, item.count});
+        content_group.push_back({addresses.ranks[item.channel],
+                                 addresses.ranks[unit.owner],
+                                 unit.content_id,
+                                 unit_rank,
+                                 file_rank,
+                                 item.count});
+    }
+
+    uint64_t total_view_all_files_count = 0;
+    // collect storages final result
+    for (uint32_t rank = 0; rank != storage_group.size(); ++rank)
+    {
+        if (0 == storage_group[rank])
+            continue;
+
+        total_view_all_files_count += storage_group[rank];
+        storage_result.emplace_hint(storage_result.end(),
+                                    addresses.ranked(rank),
+                                    std::make_pair(storage_group[rank], uint64_t(1)));
+    }
+
+    for (auto& item_result : storage_result)
+        item_result.second.second *= total_view_all_files_count;
+
+    sort_and_merge(author_group, [](author_item const& item)
+    {
+        return std::make_tuple(item.unit, item.file);
+    });
+
+    uint64_t total_view_units_count = 0;
+    // collect authors final result
+    for (auto it = author_group.begin(); it != author_group.end();)
+    {
+        auto it_end = it;
+        uint64_t total = 0;
+        for (; it_end != author_group.end() && it_end->unit == it->unit; ++it_end)
+            total += it_end->count;
+
+        uint64_t file_count = uint64_t(it_end - it);
+
+        // get average value as a unit usage
+        total /= file_count;
+
+        total_view_units_count += total;
+
+        if (0 == total)
+            throw std::logic_error("0 == total");
+
+        for (; it != it_end; ++it)
+        {
+            File const& file = lookup.get_file(file_uris.ranked(it->file));
+            uint64_t authors_count = file.author_addresses.size();
+
+            for (auto const& author_address : file.author_addresses)
+                author_result.insert({author_address, {total, file_count * authors_count}});
+        }
+    }
+
+    for (auto& item_result : author_result)
+        item_result.second.second *= total_view_units_count;
+
+    sort_and_merge(content_group, [](content_item const& item)
+    {
+        return std::make_tuple(item.channel, item.owner, item.content_id, item.unit, item.file);
+    });
+
+    // one run per serving and owner channel, the runs are counted in parallel
+    vector<pair<size_t, size_t>> runs;
+    for (size_t begin = 0; begin != content_group.size();)
+    {
+        size_t end = begin;
+        while (end != content_group.size() &&
+               content_group[end].channel == content_group[begin].channel &&
+               content_group[end].owner == content_group[begin].owner)
+            ++end;
+
+        runs.push_back({begin, end});
+        begin = end;
+    }
+
+    vector<uint64_t> run_counts(runs.size(), 0);
+    parallel_for(runs.size(), lookup.threads, [&](size_t index)
+    {
+        auto it = content_group.begin() + runs[index].first;
+        auto it_end = content_group.begin() + runs[index].second;
+
+        uint64_t count = 0;
+        uint64_t max_count_per_content_id = 0;
+        for (auto it_item = it; it_item != it_end; ++it_item)
+        {
+            max_count_per_content_id = std::max(max_count_per_content_id, it_item->count);
+            if (it_item + 1 == it_end ||
+                (it_item + 1)->content_id != it_item->content_id)
+            {
+                count += max_count_per_content_id;
+                max_count_per_content_id = 0;
+            }
+        }
+
+        if (lookup.counts_per_channel_views)
+        {
+            //  the run is sorted by content id, unit and file already
+            vector<pair<uint64_t, uint64_t>> content_views;
+            content_views.reserve(size_t(it_end - it));
+            for (auto it_item = it; it_item != it_end; ++it_item)
+                content_views.push_back({it_item->content_id, it_item->count});
+
+            count = lookup.counts_per_channel_views(content_views,
+                                                    block_number,
+                                                    lookup.testnet);
+        }
+
+        run_counts[index] = count;
+    });
+
+    uint64_t total_channel_view_count = 0;
+    // collect channels final result, merged in run order
+    for (size_t index = 0; index != runs.size(); ++index)
+    {
+        auto it = content_group.begin() + runs[index].first;
+        auto it_end = content_group.begin() + runs[index].second;
+
+        string const& serving_channel = addresses.ranked(it->channel);
+        string const& owner_channel = addresses.ranked(it->owner);
+
+        for (auto it_item = it; it_item != it_end; ++it_item)
+        {
+            auto& unit_value = unit_uri_view_counts[unit_uris.ranked(it_item->unit)][serving_channel];
+            unit_value = std::max(unit_value, it_item->count);
+        }
+
+        uint64_t count = run_counts[index];
+        if (serving_channel == owner_channel)
+        {
+            channel_result.insert({serving_channel, {2 * count, 2}});
+        }
+        else
+        {
+            channel_result.insert({owner_channel, {count, 2}});
+            channel_result.insert({serving_channel, {count, 2}});
+        }
+
+        total_channel_view_count += count;
+    }
+
+    for (auto& item_result : channel_result)
+        item_result.second.second *= total_channel_view_count;
+}
+}// end of namespace publiqpp
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "global.hpp"
+#include "message.hpp"
+#include "node.hpp"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace publiqpp
+{
+//  what the aggregation needs to know about documents, given as callbacks
+//  so that it can be replayed without a running node
+class statistics_lookup
+{
+public:
+    std::function<BlockchainMessage::ContentUnit const& (std::string const&)> get_unit;
+    std::function<BlockchainMessage::File const& (std::string const&)> get_file;
+    //  nullptr means the default - max by file and unit, then sum by content id
+    detail::fp_counts_per_channel_views counts_per_channel_views = nullptr;
+    bool testnet = false;
+    //  storages and channels are checked in parallel, the result
+    //  does not depend on the number of threads
+    size_t threads = 1;
+};
+
+BLOCKCHAINSHARED_EXPORT bool stat_mismatch(uint64_t first, uint64_t second);
+
+//  cross verifies channel and storage reports and computes the
+//  author, channel and storage shares for one block
+BLOCKCHAINSHARED_EXPORT
+void aggregate_statistics(std::map<std::string, BlockchainMessage::ServiceStatistics> const& channel_provided_statistics,
+                          std::map<std::string, BlockchainMessage::ServiceStatistics> const& storage_provided_statistics,
+                          statistics_lookup const& lookup,
+                          uint64_t block_number,
+                          std::multimap<std::string, std::pair<uint64_t, uint64_t>>& author_result,
+                          std::multimap<std::string, std::pair<uint64_t, uint64_t>>& channel_result,
+                          std::multimap<std::string, std::pair<uint64_t, uint64_t>>& storage_result,
+                          //       uri                    channel      views
+                          std::map<std::string, std::map<std::string, uint64_t>>& unit_uri_view_counts);
+}// end of namespace publiqpp
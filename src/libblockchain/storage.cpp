@@ -10,9 +10,17 @@
 #include <belt.pp/utility.hpp>
 
 #include <string>
+#include <algorithm>
+#include <map>
+#include <list>
+#include <queue>
+#include <vector>
+#include <functional>
 
 namespace filesystem = boost::filesystem;
 using std::string;
+using std::vector;
+using std::pair;
 using std::unordered_map;
 using std::unordered_set;
 
@@ -21,104 +29,640 @@ namespace publiqpp
 
 namespace detail
 {
+inline
+beltpp::void_unique_ptr get_putl_types()
+{
+    beltpp::message_loader_utility utl;
+    StorageTypes::detail::extension_helper(utl);
+
+    auto ptr_utl =
+        beltpp::new_void_unique_ptr<beltpp::message_loader_utility>(std::move(utl));
+
+    return ptr_utl;
+}
+
+//  gear table for the rolling hash, generated with splitmix64 from a fixed
+//  seed so that all nodes cut the same content at the same boundaries
+class gear_table
+{
+public:
+    gear_table()
+    {
+        uint64_t state = 0x7075626c69717070ull;
+        for (auto& item : values)
+        {
+            state += 0x9e3779b97f4a7c15ull;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            item = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t values[256];
+};
+
+//  splits data into content defined chunks, returns (offset, length) pairs
+vector<pair<size_t, size_t>> content_defined_chunks(string const& data)
+{
+    static gear_table const table;
+    //  the high bits of the gear hash depend on the widest window
+    uint64_t const mask = ((uint64_t(1) << STORAGE_DEDUP_CHUNK_AVG_BITS) - 1) <<
+                          (64 - STORAGE_DEDUP_CHUNK_AVG_BITS);
+
+    vector<pair<size_t, size_t>> result;
+    size_t start = 0;
+    while (start < data.size())
+    {
+        size_t end = std::min(data.size(), start + size_t(STORAGE_DEDUP_CHUNK_MAX_SIZE));
+        size_t position = std::min(end, start + size_t(STORAGE_DEDUP_CHUNK_MIN_SIZE));
+
+        uint64_t fingerprint = 0;
+        while (position < end)
+        {
+            fingerprint = (fingerprint << 1) +
+                          table.values[static_cast<uint8_t>(data[position])];
+            ++position;
+            if (0 == (fingerprint & mask))
+                break;
+        }
+
+        result.push_back(std::make_pair(start, position - start));
+        start = position;
+    }
+
+    return result;
+}
+
 class storage_internals
 {
 public:
     storage_internals(filesystem::path const& path)
         : map("storage", path, 10000, detail::get_putl())
+        , manifests("storage_manifest", path, 10000, get_putl_types())
+        , chunks("storage_chunk", path, 10000, get_putl_types())
+        , usage("storage_usage", path, 1, detail::get_putl())
+        , channel_usage("storage_channel_usage", path, 1000, detail::get_putl())
+        , uri_index("storage_uri_index", path, 1000, get_putl_types())
     {}
 
+    void save()
+    {
+        map.save();
+        manifests.save();
+        chunks.save();
+        usage.save();
+        channel_usage.save();
+        uri_index.save();
+    }
+
+    void commit() noexcept
+    {
+        map.commit();
+        manifests.commit();
+        chunks.commit();
+        usage.commit();
+        channel_usage.commit();
+        uri_index.commit();
+    }
+
+    void discard() noexcept
+    {
+        map.discard();
+        manifests.discard();
+        chunks.discard();
+        usage.discard();
+        channel_usage.discard();
+        uri_index.discard();
+    }
+
+    BlockchainMessage::StorageUsage& usage_ref()
+    {
+        return usage.at("usage");
+    }
+
+    //  files uploaded directly, not replicated from a channel, are
+    //  accounted under the empty channel address
+    void channel_add(string const& channel_address, uint64_t size)
+    {
+        if (false == channel_usage.contains(channel_address))
+        {
+            BlockchainMessage::StorageChannelUsage item;
+            item.channel_address = channel_address;
+            item.file_count = 0;
+            item.logical_size = 0;
+
+            channel_usage.insert(channel_address, item);
+        }
+
+        auto& item = channel_usage.at(channel_address);
+        ++item.file_count;
+        item.logical_size += size;
+    }
+
+    //  stored uris are indexed in buckets by their leading characters,
+    //  buckets ordered by key hold uris ordered the same way
+    static string uri_bucket(string const& uri)
+    {
+        return uri.substr(0, STORAGE_URI_INDEX_PREFIX);
+    }
+
+    void index_uri(string const& uri)
+    {
+        string bucket_key = uri_bucket(uri);
+        if (false == uri_index.contains(bucket_key))
+        {
+            StorageTypes::StorageUriBucket bucket;
+            bucket.uris.insert(uri);
+            uri_index.insert(bucket_key, bucket);
+        }
+        else
+            uri_index.at(bucket_key).uris.insert(uri);
+    }
+
+    void unindex_uri(string const& uri)
+    {
+        string bucket_key = uri_bucket(uri);
+        auto& bucket = uri_index.at(bucket_key);
+        bucket.uris.erase(uri);
+        if (bucket.uris.empty())
+            uri_index.erase(bucket_key);
+    }
+
+    void channel_remove(string const& channel_address, uint64_t size)
+    {
+        auto& item = channel_usage.at(channel_address);
+        if (item.file_count > 1)
+        {
+            --item.file_count;
+            item.logical_size -= size;
+        }
+        else
+            channel_usage.erase(channel_address);
+    }
+
+    //  decodes a file stored as a whole, keeps the most recently used ones
+    string const& decoded_file(string const& uri)
+    {
+        for (auto it = decoded_files.begin(); it != decoded_files.end(); ++it)
+        {
+            if (it->first == uri)
+            {
+                decoded_files.splice(decoded_files.begin(), decoded_files, it);
+                return decoded_files.front().second;
+            }
+        }
+
+        decoded_files.emplace_front(uri, meshpp::from_base64(map.as_const().at(uri).data));
+        if (decoded_files.size() > STORAGE_DECODED_FILES_CACHE)
+            decoded_files.pop_back();
+
+        return decoded_files.front().second;
+    }
+
+    void forget_decoded_file(string const& uri)
+    {
+        decoded_files.remove_if([&uri](pair<string, string> const& item)
+        {
+            return item.first == uri;
+        });
+    }
+
+    //  files stored as a whole before the chunk store was introduced
     meshpp::map_loader<BlockchainMessage::StorageFile> map;
+    meshpp::map_loader<StorageTypes::StorageFileManifest> manifests;
+    meshpp::map_loader<StorageTypes::StorageChunk> chunks;
+    meshpp::map_loader<BlockchainMessage::StorageUsage> usage;
+    meshpp::map_loader<BlockchainMessage::StorageChannelUsage> channel_usage;
+    meshpp::map_loader<StorageTypes::StorageUriBucket> uri_index;
+    std::list<pair<string, string>> decoded_files;
 };
 }
 
 storage::storage(boost::filesystem::path const& fs_storage)
     : m_pimpl(new detail::storage_internals(fs_storage))
-{}
+{
+    auto& impl = *m_pimpl;
+    if (impl.usage.contains("usage"))
+        return;
+
+    //  first start with the chunk store, account the files stored as a whole
+    BlockchainMessage::StorageUsage usage;
+    usage.file_count = 0;
+    usage.chunk_count = 0;
+    usage.logical_size = 0;
+    usage.stored_size = 0;
+
+    beltpp::on_failure guard([&impl]
+    {
+        impl.discard();
+    });
+
+    for (auto const& uri : impl.map.keys())
+    {
+        uint64_t size = meshpp::from_base64(impl.map.as_const().at(uri).data).size();
+        ++usage.file_count;
+        usage.logical_size += size;
+        usage.stored_size += size;
+
+        impl.channel_add(string(), size);
+        impl.index_uri(uri);
+    }
+
+    impl.usage.insert("usage", usage);
+    impl.save();
+
+    guard.dismiss();
+    impl.commit();
+}
 storage::~storage()
 {}
 
 bool storage::put(BlockchainMessage::StorageFile&& file, string& uri)
 {
-    bool code = false;
     uri = meshpp::hash(file.data);
-    file.data = meshpp::to_base64(file.data, true);
-    beltpp::on_failure guard([this]
+    return put_verified(std::move(file), uri, string());
+}
+
+//  the caller has already checked that uri is the hash of file data
+bool storage::put_verified(BlockchainMessage::StorageFile&& file,
+                           string const& uri,
+                           string const& channel_address)
+{
+    auto& impl = *m_pimpl;
+    if (impl.map.contains(uri) ||
+        impl.manifests.contains(uri))
+        return false;
+
+    beltpp::on_failure guard([&impl]
     {
-        m_pimpl->map.discard();
+        impl.discard();
     });
 
-    if (m_pimpl->map.insert(uri, file))
-        code = true;
+    auto& usage = impl.usage_ref();
 
-    m_pimpl->map.save();
+    StorageTypes::StorageFileManifest manifest;
+    manifest.mime_type = std::move(file.mime_type);
+    manifest.size = file.data.size();
+    manifest.channel_address = channel_address;
+
+    for (auto const& range : detail::content_defined_chunks(file.data))
+    {
+        string chunk_data = file.data.substr(range.first, range.second);
+        string chunk_hash = meshpp::hash(chunk_data);
+
+        if (impl.chunks.contains(chunk_hash))
+            ++impl.chunks.at(chunk_hash).references;
+        else
+        {
+            StorageTypes::StorageChunk chunk;
+            chunk.data = meshpp::to_base64(chunk_data, true);
+            chunk.size = chunk_data.size();
+            chunk.references = 1;
+
+            impl.chunks.insert(chunk_hash, chunk);
+
+            ++usage.chunk_count;
+            usage.stored_size += chunk.size;
+        }
+
+        manifest.chunk_hashes.push_back(std::move(chunk_hash));
+    }
+
+    ++usage.file_count;
+    usage.logical_size += manifest.size;
+    impl.channel_add(channel_address, manifest.size);
+
+    impl.manifests.insert(uri, manifest);
+    impl.index_uri(uri);
+    impl.save();
 
     guard.dismiss();
-    m_pimpl->map.commit();
-    return code;
+    impl.commit();
+
+    return true;
 }
 
 bool storage::get(string const& uri, BlockchainMessage::StorageFile& file)
 {
-    if (false == m_pimpl->map.contains(uri))
+    auto& impl = *m_pimpl;
+    if (impl.manifests.contains(uri))
+    {
+        auto const& manifest = impl.manifests.as_const().at(uri);
+
+        file.mime_type = manifest.mime_type;
+        file.data.clear();
+        file.data.reserve(manifest.size);
+        for (auto const& chunk_hash : manifest.chunk_hashes)
+            file.data += meshpp::from_base64(impl.chunks.as_const().at(chunk_hash).data);
+    }
+    else if (impl.map.contains(uri))
+    {
+        file = impl.map.as_const().at(uri);
+
+        file.data = meshpp::from_base64(file.data);
+    }
+    else
         return false;
 
-    file = m_pimpl->map.as_const().at(uri);
+    if (beltpp::chance_one_of(1000))
+    {
+        impl.map.discard();
+        impl.manifests.discard();
+        impl.chunks.discard();
+    }
+
+    return true;
+}
+
+//  only the stored chunks the requested range overlaps are decoded
+bool storage::get_chunk(string const& uri,
+                        uint64_t offset,
+                        uint64_t max_length,
+                        BlockchainMessage::StorageFileChunk& chunk)
+{
+    auto& impl = *m_pimpl;
+    if (impl.manifests.contains(uri))
+    {
+        auto const& manifest = impl.manifests.as_const().at(uri);
+        if (offset > manifest.size)
+            return false;
+
+        chunk.mime_type = manifest.mime_type;
+        chunk.total_size = manifest.size;
+        chunk.data.clear();
+
+        uint64_t end = std::min(manifest.size, offset + max_length);
+        uint64_t chunk_offset = 0;
+        for (auto const& chunk_hash : manifest.chunk_hashes)
+        {
+            if (chunk_offset >= end)
+                break;
+
+            auto const& stored_chunk = impl.chunks.as_const().at(chunk_hash);
+            uint64_t chunk_end = chunk_offset + stored_chunk.size;
+
+            if (chunk_end > offset)
+            {
+                string data = meshpp::from_base64(stored_chunk.data);
 
-    file.data = meshpp::from_base64(file.data);
+                uint64_t from = std::max(offset, chunk_offset) - chunk_offset;
+                uint64_t to = std::min(end, chunk_end) - chunk_offset;
+                chunk.data.append(data, from, to - from);
+            }
+
+            chunk_offset = chunk_end;
+        }
+    }
+    else if (impl.map.contains(uri))
+    {
+        string const& data = impl.decoded_file(uri);
+        if (offset > data.size())
+            return false;
+
+        chunk.mime_type = impl.map.as_const().at(uri).mime_type;
+        chunk.total_size = data.size();
+        chunk.data = data.substr(offset, max_length);
+    }
+    else
+        return false;
+
+    chunk.uri = uri;
+    chunk.offset = offset;
 
     if (beltpp::chance_one_of(1000))
-        m_pimpl->map.discard();
+    {
+        impl.map.discard();
+        impl.manifests.discard();
+        impl.chunks.discard();
+    }
 
     return true;
 }
 
 bool storage::remove(string const& uri)
 {
-    if (false == m_pimpl->map.contains(uri))
+    auto& impl = *m_pimpl;
+    bool in_manifests = impl.manifests.contains(uri);
+    if (false == in_manifests &&
+        false == impl.map.contains(uri))
         return false;
 
-    beltpp::on_failure guard([this]
+    beltpp::on_failure guard([&impl]
     {
-        m_pimpl->map.discard();
+        impl.discard();
     });
-    m_pimpl->map.erase(uri);
-    m_pimpl->map.save();
+
+    auto& usage = impl.usage_ref();
+
+    if (in_manifests)
+    {
+        auto manifest = impl.manifests.as_const().at(uri);
+
+        for (auto const& chunk_hash : manifest.chunk_hashes)
+        {
+            auto& chunk = impl.chunks.at(chunk_hash);
+            if (chunk.references > 1)
+                --chunk.references;
+            else
+            {
+                --usage.chunk_count;
+                usage.stored_size -= chunk.size;
+                impl.chunks.erase(chunk_hash);
+            }
+        }
+
+        usage.logical_size -= manifest.size;
+        impl.channel_remove(manifest.channel_address, manifest.size);
+        impl.manifests.erase(uri);
+    }
+    else
+    {
+        uint64_t size = meshpp::from_base64(impl.map.as_const().at(uri).data).size();
+        usage.logical_size -= size;
+        usage.stored_size -= size;
+        impl.channel_remove(string(), size);
+        impl.map.erase(uri);
+    }
+
+    --usage.file_count;
+    impl.unindex_uri(uri);
+    impl.save();
 
     guard.dismiss();
-    m_pimpl->map.commit();
+    impl.commit();
+
+    impl.forget_decoded_file(uri);
 
     return true;
 }
 
-unordered_set<string> storage::get_file_uris() const
+vector<string> storage::stored_file_uris(vector<string> const& file_uris) const
 {
-    return m_pimpl->map.keys();
+    vector<string> result;
+    for (auto const& file_uri : file_uris)
+    {
+        if (m_pimpl->manifests.contains(file_uri) ||
+            m_pimpl->map.contains(file_uri))
+            result.push_back(file_uri);
+    }
+
+    return result;
 }
 
-namespace detail
+vector<string> storage::get_file_uris(string const& start_after,
+                                     size_t max_count,
+                                     bool& more) const
 {
-inline
-beltpp::void_unique_ptr get_putl_types()
+    auto& impl = *m_pimpl;
+
+    //  only the bucket keys are sorted here, at most
+    //  the number of distinct uri prefixes
+    auto bucket_key_set = impl.uri_index.keys();
+    vector<string> bucket_keys(bucket_key_set.begin(), bucket_key_set.end());
+    std::sort(bucket_keys.begin(), bucket_keys.end());
+
+    vector<string> result;
+    more = false;
+
+    auto it = std::lower_bound(bucket_keys.begin(), bucket_keys.end(),
+                               detail::storage_internals::uri_bucket(start_after));
+    for (; it != bucket_keys.end(); ++it)
+    {
+        auto const& bucket = impl.uri_index.as_const().at(*it);
+
+        vector<string> bucket_uris;
+        for (auto const& uri : bucket.uris)
+        {
+            if (uri > start_after)
+                bucket_uris.push_back(uri);
+        }
+        std::sort(bucket_uris.begin(), bucket_uris.end());
+
+        size_t count = std::min(bucket_uris.size(), max_count - result.size());
+        result.insert(result.end(), bucket_uris.begin(), bucket_uris.begin() + count);
+
+        if (count < bucket_uris.size())
+        {
+            more = true;
+            break;
+        }
+        if (result.size() == max_count)
+        {
+            //  buckets are erased when emptied, so any next one has uris
+            more = (it + 1 != bucket_keys.end());
+            break;
+        }
+    }
+
+    return result;
+}
+
+BlockchainMessage::StorageUsage storage::usage() const
 {
-    beltpp::message_loader_utility utl;
-    StorageTypes::detail::extension_helper(utl);
+    BlockchainMessage::StorageUsage result = m_pimpl->usage.as_const().at("usage");
 
-    auto ptr_utl =
-        beltpp::new_void_unique_ptr<beltpp::message_loader_utility>(std::move(utl));
+    auto channel_addresses = m_pimpl->channel_usage.keys();
+    result.channels.reserve(channel_addresses.size());
+    for (auto const& channel_address : channel_addresses)
+        result.channels.push_back(m_pimpl->channel_usage.as_const().at(channel_address));
 
-    return ptr_utl;
+    return result;
 }
 
+namespace detail
+{
 class storage_controller_internals
 {
 public:
     storage_controller_internals(filesystem::path const& path)
         : map("file_requests", path, 100, get_putl_types())
+        , index_loaded(false)
+        , next_order(0)
     {}
 
+    //  file requests waiting to be handed out, ordered by age per channel
+    using order_queue = std::map<uint64_t, string>;
+
+    void load_index()
+    {
+        if (index_loaded)
+            return;
+
+        //  this full scan happens once on startup and after a discard,
+        //  the already known files keep their original order
+        unordered_map<string, file_order> old_file_orders = std::move(file_orders);
+        file_orders.clear();
+        channel_queues.clear();
+
+        auto file_uris = map.as_const().keys();
+        for (auto const& file_uri : file_uris)
+        {
+            auto const& file_request = map.as_const().at(file_uri);
+
+            uint64_t order;
+            auto it_old = old_file_orders.find(file_uri);
+            if (it_old != old_file_orders.end() &&
+                it_old->second.channel_address == file_request.channel_address)
+                order = it_old->second.order;
+            else
+                order = next_order++;
+
+            file_orders[file_uri] = file_order{file_request.channel_address, order};
+
+            if (false == is_requesting(file_uri, file_request.channel_address))
+                channel_queues[file_request.channel_address][order] = file_uri;
+        }
+
+        index_loaded = true;
+    }
+
+    bool is_requesting(string const& file_uri, string const& channel_address) const
+    {
+        auto it_channel = channels_files_requesting.find(channel_address);
+        if (it_channel == channels_files_requesting.end())
+            return false;
+        return it_channel->second.count(file_uri) > 0;
+    }
+
+    void queue_push(string const& file_uri)
+    {
+        auto it_order = file_orders.find(file_uri);
+        if (it_order != file_orders.end())
+            channel_queues[it_order->second.channel_address][it_order->second.order] = file_uri;
+    }
+
+    void queue_erase(string const& file_uri)
+    {
+        auto it_order = file_orders.find(file_uri);
+        if (it_order == file_orders.end())
+            return;
+
+        auto it_queue = channel_queues.find(it_order->second.channel_address);
+        if (it_queue != channel_queues.end())
+        {
+            it_queue->second.erase(it_order->second.order);
+            if (it_queue->second.empty())
+                channel_queues.erase(it_queue);
+        }
+
+        file_orders.erase(it_order);
+    }
+
+    class file_order
+    {
+    public:
+        string channel_address;
+        uint64_t order;
+    };
+
     meshpp::map_loader<StorageTypes::FileRequest> map;
     unordered_map<string, unordered_map<string, bool>> channels_files_requesting;
+
+    bool index_loaded;
+    uint64_t next_order;
+    unordered_map<string, file_order> file_orders;
+    unordered_map<string, order_queue> channel_queues;
 };
 
 }
@@ -149,6 +693,8 @@ void storage_controller::discard() noexcept
     if (nullptr == m_pimpl)
         return;
     m_pimpl->map.discard();
+    //  the index will be rebuilt from the stored requests on next use
+    m_pimpl->index_loaded = false;
 }
 
 void storage_controller::clear()
@@ -156,6 +702,8 @@ void storage_controller::clear()
     if (nullptr == m_pimpl)
         return;
     m_pimpl->map.clear();
+    m_pimpl->file_orders.clear();
+    m_pimpl->channel_queues.clear();
 }
 
 void storage_controller::enqueue(string const& file_uri, string const& channel_address)
@@ -166,7 +714,12 @@ void storage_controller::enqueue(string const& file_uri, string const& channel_a
     StorageTypes::FileRequest fr;
     fr.file_uri = file_uri;
     fr.channel_address = channel_address;
-    m_pimpl->map.insert(file_uri, fr);
+    if (m_pimpl->map.insert(file_uri, fr) &&
+        m_pimpl->index_loaded)
+    {
+        m_pimpl->file_orders[file_uri] = detail::storage_controller_internals::file_order{channel_address, m_pimpl->next_order++};
+        m_pimpl->queue_push(file_uri);
+    }
 }
 
 void storage_controller::pop(string const& file_uri, string const& channel_address)
@@ -182,6 +735,9 @@ void storage_controller::pop(string const& file_uri, string const& channel_addre
             throw std::logic_error("pop: it_file != it_channel->second.end()");
     }
 
+    if (false == m_pimpl->map.contains(file_uri))
+        return;
+
     auto const& fr = m_pimpl->map.as_const().at(file_uri);
     if (fr.channel_address == channel_address)
     {
@@ -190,6 +746,8 @@ void storage_controller::pop(string const& file_uri, string const& channel_addre
         save();
         guard.dismiss();
         commit();
+
+        m_pimpl->queue_erase(file_uri);
     }
 }
 
@@ -220,6 +778,11 @@ void storage_controller::initiate(string const& file_uri,
         it_channel->second.erase(it_file);
         if (it_channel->second.empty())
             m_pimpl->channels_files_requesting.erase(it_channel);
+
+        //  the request goes back to the queue keeping its age,
+        //  unless it is popped right after this
+        if (m_pimpl->index_loaded)
+            m_pimpl->queue_push(file_uri);
     }
 }
 
@@ -229,49 +792,83 @@ unordered_map<string, string> storage_controller::get_file_requests(unordered_se
     if (nullptr == m_pimpl)
         return file_to_channel;
 
+    m_pimpl->load_index();
+
     size_t count_all = 0;
     for (auto const& item : m_pimpl->channels_files_requesting)
         count_all += item.second.size();
-    if (count_all)
-        return file_to_channel;
 
-    auto file_uris = m_pimpl->map.as_const().keys();
+    //  keep the queues of the first few unresolved channels
+    //  and forget about the requests of the rest
+    size_t unresolved_channels = 0;
+    vector<string> channels_to_forget;
 
-    unordered_set<string> unresolved_channels;
+    //  (order of the oldest waiting request, channel)
+    using channel_head = pair<uint64_t, string>;
+    std::priority_queue<channel_head, vector<channel_head>, std::greater<channel_head>> heads;
 
-    for (auto const& file_uri : file_uris)
+    for (auto const& item : m_pimpl->channel_queues)
     {
-        auto const& file_request = m_pimpl->map.as_const().at(file_uri);
+        auto const& channel_address = item.first;
+        auto const& queue = item.second;
+        assert(false == queue.empty());
 
-        if (0 == resolved_channels.count(file_request.channel_address))
+        if (0 == resolved_channels.count(channel_address))
         {
-            if (10 == unresolved_channels.size())
-            {
-                if (0 == unresolved_channels.count(file_request.channel_address))
-                    m_pimpl->map.erase(file_uri);
-            }
+            if (STORAGE_MAX_UNRESOLVED_CHANNELS == unresolved_channels)
+                channels_to_forget.push_back(channel_address);
             else
-                unresolved_channels.insert(file_request.channel_address);
+                ++unresolved_channels;
 
             continue;
         }
 
-        if (count_all == STORAGE_MAX_FILE_REQUESTS)
-            continue;   //  might as well break, but will let to collect the unresolved channels
-
-        /*if (STORAGE_MAX_FILE_REQUESTS == m_pimpl->channels_files_requesting.size() &&
-            0 == m_pimpl->channels_files_requesting.count(file_request.channel_address))
-            continue;*/
+        heads.push(std::make_pair(queue.begin()->first, channel_address));
+    }
 
-        auto insert_res = m_pimpl->channels_files_requesting[file_request.channel_address].insert({file_uri, false});
+    for (auto const& channel_address : channels_to_forget)
+    {
+        auto it_queue = m_pimpl->channel_queues.find(channel_address);
+        vector<string> file_uris;
+        for (auto const& item : it_queue->second)
+            file_uris.push_back(item.second);
 
-        if (insert_res.second)
+        for (auto const& file_uri : file_uris)
         {
-            ++count_all;
-            file_to_channel[file_uri] = file_request.channel_address;
+            m_pimpl->map.erase(file_uri);
+            m_pimpl->queue_erase(file_uri);
         }
     }
 
+    //  hand out the oldest requests first, while keeping
+    //  each channel within its own concurrency window
+    while (count_all < STORAGE_MAX_FILE_REQUESTS &&
+           false == heads.empty())
+    {
+        string channel_address = heads.top().second;
+        heads.pop();
+
+        auto& requesting = m_pimpl->channels_files_requesting[channel_address];
+        if (requesting.size() >= STORAGE_MAX_CHANNEL_FILE_REQUESTS)
+            continue;   //  the channel window is full, it will be refilled as requests complete
+
+        auto it_queue = m_pimpl->channel_queues.find(channel_address);
+        assert(it_queue != m_pimpl->channel_queues.end());
+
+        auto it_head = it_queue->second.begin();
+        string file_uri = it_head->second;
+        it_queue->second.erase(it_head);
+
+        requesting.insert({file_uri, false});
+        file_to_channel[file_uri] = channel_address;
+        ++count_all;
+
+        if (it_queue->second.empty())
+            m_pimpl->channel_queues.erase(it_queue);
+        else
+            heads.push(std::make_pair(it_queue->second.begin()->first, channel_address));
+    }
+
     return file_to_channel;
 }
 
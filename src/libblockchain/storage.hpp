@@ -27,9 +27,20 @@ public:
     ~storage();
 
     bool put(BlockchainMessage::StorageFile&& file, std::string& uri);
+    bool put_verified(BlockchainMessage::StorageFile&& file,
+                      std::string const& uri,
+                      std::string const& channel_address);
     bool get(std::string const& uri, BlockchainMessage::StorageFile& file);
+    bool get_chunk(std::string const& uri,
+                   uint64_t offset,
+                   uint64_t max_length,
+                   BlockchainMessage::StorageFileChunk& chunk);
     bool remove(std::string const& uri);
-    std::unordered_set<std::string> get_file_uris() const;
+    std::vector<std::string> stored_file_uris(std::vector<std::string> const& file_uris) const;
+    std::vector<std::string> get_file_uris(std::string const& start_after,
+                                           size_t max_count,
+                                           bool& more) const;
+    BlockchainMessage::StorageUsage usage() const;
 private:
     std::unique_ptr<detail::storage_internals> m_pimpl;
 };
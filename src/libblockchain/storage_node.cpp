@@ -5,8 +5,6 @@
 #include "message.tmpl.hpp"
 #include "open_container_packet.hpp"
 
-#include <publiq.pp/storage_utility_rpc.hpp>
-
 #include <vector>
 #include <string>
 #include <memory>
@@ -16,6 +14,7 @@
 #include <utility>
 #include <exception>
 #include <thread>
+#include <algorithm>
 
 using namespace BlockchainMessage;
 
@@ -34,6 +33,9 @@ using std::unordered_set;
 
 namespace publiqpp
 {
+//  free functions
+void process_wait_result(std::unique_ptr<detail::storage_node_internals>& m_pimpl,
+                         detail::wait_result_item& wait_result);
 
 /*
  * storage_node
@@ -65,10 +67,23 @@ void storage_node::run(bool& stop)
 {
     stop = false;
 
-    unordered_set<beltpp::ievent_item const*> wait_sockets;
+    //  everything ready by now is handled in one go,
+    //  the ones left after an exception are handled on the next run
+    if (m_pimpl->m_wait_results.empty())
+        m_pimpl->m_wait_results = m_pimpl->wait_and_receive();
+
+    while (false == m_pimpl->m_wait_results.empty())
+    {
+        auto wait_result = std::move(m_pimpl->m_wait_results.front());
+        m_pimpl->m_wait_results.pop_front();
 
-    auto wait_result = m_pimpl->wait_and_receive_one();
+        process_wait_result(m_pimpl, wait_result);
+    }
+}
 
+void process_wait_result(std::unique_ptr<detail::storage_node_internals>& m_pimpl,
+                         detail::wait_result_item& wait_result)
+{
     if (wait_result.et == detail::wait_result_item::event)
     {
         auto peerid = wait_result.peerid;
@@ -118,51 +133,49 @@ void storage_node::run(bool& stop)
                 StorageFileRequest file_info;
                 std::move(ref_packet).get(file_info);
 
-                string file_uri;
+                string file_uri = m_pimpl->file_uri_to_serve(file_info.uri,
+                                                             file_info.storage_order_token);
 
-                if (m_pimpl->m_node_type == NodeType::storage)
+                StorageFile file;
+                if (false == file_uri.empty() &&
+                    m_pimpl->m_storage.get(file_uri, file))
                 {
-                    string channel_address;
-                    string storage_address;
-                    string content_unit_uri;
-                    string session_id;
-                    uint64_t seconds;
-                    system_clock::time_point tp;
-
-                    if (false == storage_utility::rpc::verify_storage_order(file_info.storage_order_token,
-                                                                            channel_address,
-                                                                            storage_address,
-                                                                            file_uri,
-                                                                            content_unit_uri,
-                                                                            session_id,
-                                                                            seconds,
-                                                                            tp) ||
-                        storage_address != m_pimpl->m_pv_key.get_public_key().to_string() ||
-                        0 == m_pimpl->m_verified_channels.count(channel_address))
-                        file_uri.clear();
+                    psk->send(peerid, beltpp::packet(std::move(file)));
+
+                    m_pimpl->served(file_info.storage_order_token);
                 }
                 else
                 {
-                    file_uri = file_info.uri;
+                    UriError error;
+                    error.uri = file_uri;
+                    error.uri_problem_type = UriProblemType::missing;
+                    psk->send(peerid, beltpp::packet(std::move(error)));
                 }
 
-                StorageFile file;
+                break;
+            }
+            case StorageFileChunkRequest::rtt:
+            {
+                StorageFileChunkRequest chunk_request;
+                std::move(ref_packet).get(chunk_request);
+
+                string file_uri = m_pimpl->file_uri_to_serve(chunk_request.uri,
+                                                             chunk_request.storage_order_token);
+
+                uint64_t length = std::min(chunk_request.max_length,
+                                           uint64_t(STORAGE_FILE_CHUNK_SIZE));
+
+                StorageFileChunk chunk;
                 if (false == file_uri.empty() &&
-                    m_pimpl->m_storage.get(file_uri, file))
+                    m_pimpl->m_storage.get_chunk(file_uri,
+                                                 chunk_request.offset,
+                                                 length,
+                                                 chunk))
                 {
-                    psk->send(peerid, beltpp::packet(std::move(file)));
-
-                    if (m_pimpl->m_node_type == NodeType::storage)
-                    {
-                        std::lock_guard<std::mutex> lock(m_pimpl->m_messages_mutex);
-                        Served msg;
-                        msg.storage_order_token = file_info.storage_order_token;
+                    psk->send(peerid, beltpp::packet(std::move(chunk)));
 
-                        StorageTypes::ContainerMessage msg_response;
-                        msg_response.package.set(msg);
-                        m_pimpl->m_messages.push_back(std::make_pair(beltpp::packet(), packet(std::move(msg_response))));
-                        m_pimpl->m_master_node->wake();
-                    }
+                    if (0 == chunk_request.offset)
+                        m_pimpl->served(chunk_request.storage_order_token);
                 }
                 else
                 {
@@ -199,6 +212,11 @@ void storage_node::run(bool& stop)
 
                 break;
             }
+            case StorageUsageRequest::rtt:
+            {
+                psk->send(peerid, beltpp::packet(m_pimpl->m_storage.usage()));
+                break;
+            }
             case Ping::rtt:
             {
                 Pong msg_pong;
@@ -266,8 +284,18 @@ void storage_node::run(bool& stop)
                     StorageFile storage_file;
                     std::move(storage_file_ex.storage_file).get(storage_file);
 
-                    string uri;
-                    if (m_pimpl->m_storage.put(std::move(storage_file), uri))
+                    //  files replicated from channels come already verified,
+                    //  no need to hash them once more
+                    string uri = storage_file_ex.verified_uri;
+                    bool inserted;
+                    if (uri.empty())
+                        inserted = m_pimpl->m_storage.put(std::move(storage_file), uri);
+                    else
+                        inserted = m_pimpl->m_storage.put_verified(std::move(storage_file),
+                                                                   uri,
+                                                                   storage_file_ex.channel_address);
+
+                    if (inserted)
                     {
                         StorageFileAddress file_address;
                         file_address.uri = uri;
@@ -337,14 +365,13 @@ void storage_node::run(bool& stop)
                     m_pimpl->m_master_node->wake();
                     break;
                 }
-                case StorageTypes::FileUrisRequest::rtt:
+                case StorageTypes::FileUrisCheckRequest::rtt:
                 {
-                    FileUris msg;
+                    StorageTypes::FileUrisCheckRequest check_request;
+                    std::move(request).get(check_request);
 
-                    auto set_file_uris = m_pimpl->m_storage.get_file_uris();
-                    msg.file_uris.reserve(set_file_uris.size());
-                    for (auto& file_uri : set_file_uris)
-                        msg.file_uris.push_back(std::move(file_uri));
+                    FileUris msg;
+                    msg.file_uris = m_pimpl->m_storage.stored_file_uris(check_request.file_uris);
 
                     StorageTypes::ContainerMessage msg_response;
                     msg_response.package.set(msg);
@@ -352,6 +379,22 @@ void storage_node::run(bool& stop)
                     m_pimpl->m_master_node->wake();
                     break;
                 }
+                case StorageTypes::FileUrisPageRequest::rtt:
+                {
+                    StorageTypes::FileUrisPageRequest page_request;
+                    std::move(request).get(page_request);
+
+                    FileUrisPage msg;
+                    msg.file_uris = m_pimpl->m_storage.get_file_uris(page_request.start_after,
+                                                                     page_request.max_count,
+                                                                     msg.more);
+
+                    StorageTypes::ContainerMessage msg_response;
+                    msg_response.package.set(std::move(msg));
+                    response.set(std::move(msg_response));
+                    m_pimpl->m_master_node->wake();
+                    break;
+                }
                 }
             }
         }
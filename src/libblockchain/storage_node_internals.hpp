@@ -20,12 +20,15 @@
 #include <mesh.pp/p2psocket.hpp>
 #include <mesh.pp/cryptoutility.hpp>
 
+#include <publiq.pp/storage_utility_rpc.hpp>
+
 #include <boost/filesystem/path.hpp>
 
 #include <map>
 #include <chrono>
 #include <memory>
 #include <list>
+#include <deque>
 #include <utility>
 #include <mutex>
 #include <unordered_set>
@@ -98,6 +101,71 @@ public:
             plogger_storage_node->warning(value);
     }
 
+    //  returns the uri the requester is allowed to get, or empty string
+    string file_uri_to_serve(string const& uri, string const& storage_order_token) const
+    {
+        string file_uri;
+
+        if (m_node_type == NodeType::storage)
+        {
+            string channel_address;
+            string storage_address;
+            string content_unit_uri;
+            string session_id;
+            uint64_t seconds;
+            system_clock::time_point tp;
+
+            if (false == storage_utility::rpc::verify_storage_order(storage_order_token,
+                                                                    channel_address,
+                                                                    storage_address,
+                                                                    file_uri,
+                                                                    content_unit_uri,
+                                                                    session_id,
+                                                                    seconds,
+                                                                    tp) ||
+                storage_address != m_pv_key.get_public_key().to_string() ||
+                0 == m_verified_channels.count(channel_address))
+                file_uri.clear();
+        }
+        else
+        {
+            file_uri = uri;
+        }
+
+        return file_uri;
+    }
+
+    void served(string const& storage_order_token)
+    {
+        if (m_node_type != NodeType::storage)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_messages_mutex);
+        Served msg;
+        msg.storage_order_token = storage_order_token;
+
+        StorageTypes::ContainerMessage msg_response;
+        msg_response.package.set(msg);
+        m_messages.push_back(std::make_pair(beltpp::packet(), packet(std::move(msg_response))));
+        m_master_node->wake();
+    }
+
+    //  waits only for the first one, then takes whatever is ready
+    std::deque<wait_result_item> wait_and_receive()
+    {
+        std::deque<wait_result_item> results;
+
+        do
+        {
+            auto result = wait_and_receive_one();
+            if (result.et != wait_result_item::nothing)
+                results.push_back(std::move(result));
+        }
+        while (m_wait_result.m_wait_result != beltpp::event_handler::wait_result::nothing);
+
+        return results;
+    }
+
     wait_result_item wait_and_receive_one()
     {
         auto& wait_result = m_wait_result.m_wait_result;
@@ -210,6 +278,7 @@ public:
 
     unordered_set<string> m_verified_channels;
     wait_result m_wait_result;
+    std::deque<wait_result_item> m_wait_results;
 };
 
 }
@@ -30,7 +30,13 @@ void signed_transaction_validate(SignedTransaction const& signed_transaction,
 
     unordered_set<string> owners;
 
-    string signed_message = signed_transaction.transaction_details.to_string();
+    //  the signatures of received transactions may be checked in advance
+    bool verified = impl.m_transaction_verifier.take_verified(signed_transaction);
+
+    string signed_message;
+    if (false == verified)
+        signed_message = signed_transaction.transaction_details.to_string();
+
     for (auto const& authority : signed_transaction.authorizations)
     {
         if (owners.count(authority.address))
@@ -38,6 +44,9 @@ void signed_transaction_validate(SignedTransaction const& signed_transaction,
 
         owners.insert(authority.address);
 
+        if (verified)
+            continue;
+
         meshpp::public_key pb_key(authority.address);
         meshpp::signature signature_check(pb_key, signed_message, authority.signature);
     }
@@ -127,6 +136,13 @@ bool action_process_on_chain(SignedTransaction const& signed_transaction,
         code = action_process_on_chain_t(signed_transaction, *paction, impl);
         break;
     }
+    case CompactServiceStatistics::rtt:
+    {
+        CompactServiceStatistics const* paction;
+        package.get(paction);
+        code = action_process_on_chain_t(signed_transaction, *paction, impl);
+        break;
+    }
     case SponsorContentUnit::rtt:
     {
         SponsorContentUnit const* paction;
@@ -204,6 +220,13 @@ vector<string> action_owners(SignedTransaction const& signed_transaction)
         result = action_owners(*paction);
         break;
     }
+    case CompactServiceStatistics::rtt:
+    {
+        CompactServiceStatistics const* paction;
+        package.get(paction);
+        result = action_owners(*paction);
+        break;
+    }
     case SponsorContentUnit::rtt:
     {
         SponsorContentUnit const* paction;
@@ -281,6 +304,13 @@ vector<string> action_participants(SignedTransaction const& signed_transaction)
         result = action_participants(*paction);
         break;
     }
+    case CompactServiceStatistics::rtt:
+    {
+        CompactServiceStatistics const* paction;
+        package.get(paction);
+        result = action_participants(*paction);
+        break;
+    }
     case SponsorContentUnit::rtt:
     {
         SponsorContentUnit const* paction;
@@ -362,6 +392,13 @@ void action_validate(publiqpp::detail::node_internals& impl,
         action_validate(signed_transaction, *paction, check_complete);
         break;
     }
+    case CompactServiceStatistics::rtt:
+    {
+        CompactServiceStatistics const* paction;
+        package.get(paction);
+        action_validate(signed_transaction, *paction, check_complete);
+        break;
+    }
     case SponsorContentUnit::rtt:
     {
         SponsorContentUnit const* paction;
@@ -441,6 +478,13 @@ bool action_is_complete(publiqpp::detail::node_internals& impl,
         complete = action_is_complete(signed_transaction, *paction);
         break;
     }
+    case CompactServiceStatistics::rtt:
+    {
+        CompactServiceStatistics const* paction;
+        package.get(paction);
+        complete = action_is_complete(signed_transaction, *paction);
+        break;
+    }
     case SponsorContentUnit::rtt:
     {
         SponsorContentUnit const* paction;
@@ -523,6 +567,13 @@ bool action_can_apply(publiqpp::detail::node_internals const& impl,
         code = action_can_apply(impl, signed_transaction, *paction, layer);
         break;
     }
+    case CompactServiceStatistics::rtt:
+    {
+        CompactServiceStatistics const* paction;
+        package.get(paction);
+        code = action_can_apply(impl, signed_transaction, *paction, layer);
+        break;
+    }
     case SponsorContentUnit::rtt:
     {
         SponsorContentUnit const* paction;
@@ -604,6 +655,13 @@ void action_apply(publiqpp::detail::node_internals& impl,
         action_apply(impl, signed_transaction, *paction, layer);
         break;
     }
+    case CompactServiceStatistics::rtt:
+    {
+        CompactServiceStatistics const* paction;
+        package.get(paction);
+        action_apply(impl, signed_transaction, *paction, layer);
+        break;
+    }
     case SponsorContentUnit::rtt:
     {
         SponsorContentUnit const* paction;
@@ -683,6 +741,13 @@ void action_revert(publiqpp::detail::node_internals& impl,
         action_revert(impl, signed_transaction, *paction, layer);
         break;
     }
+    case CompactServiceStatistics::rtt:
+    {
+        CompactServiceStatistics const* paction;
+        package.get(paction);
+        action_revert(impl, signed_transaction, *paction, layer);
+        break;
+    }
     case SponsorContentUnit::rtt:
     {
         SponsorContentUnit const* paction;
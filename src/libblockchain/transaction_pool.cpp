@@ -25,10 +25,41 @@ class transaction_pool_internals
 public:
     transaction_pool_internals(filesystem::path const& path)
         : m_transactions("transactions", path, 100, 10, detail::get_putl())
+        , m_index_loaded(false)
     {
     }
 
+    //  the hash index is built on first lookup, push_back and pop_back keep
+    //  it up to date, discard can bring back any content so it starts over
+    void load_index()
+    {
+        if (m_index_loaded)
+            return;
+
+        m_hashes.clear();
+        m_index.clear();
+        for (size_t index = 0; index != m_transactions.size(); ++index)
+            index_push_back(m_transactions.as_const().at(index));
+
+        m_index_loaded = true;
+    }
+
+    void index_push_back(SignedTransaction const& signed_transaction)
+    {
+        m_hashes.push_back(meshpp::hash(signed_transaction.to_string()));
+        m_index[m_hashes.back()] = m_hashes.size() - 1;
+    }
+
+    void index_pop_back()
+    {
+        m_index.erase(m_hashes.back());
+        m_hashes.pop_back();
+    }
+
     meshpp::vector_loader<SignedTransaction> m_transactions;
+    bool m_index_loaded;
+    vector<string> m_hashes;
+    unordered_map<string, size_t> m_index;
 };
 }
 
@@ -53,21 +84,27 @@ void transaction_pool::commit() noexcept
 void transaction_pool::discard() noexcept
 {
     m_pimpl->m_transactions.discard();
+    m_pimpl->m_index_loaded = false;
 }
 
 void transaction_pool::clear()
 {
     m_pimpl->m_transactions.clear();
+    m_pimpl->m_index_loaded = false;
 }
 
 void transaction_pool::push_back(SignedTransaction const& signed_transaction)
 {
     m_pimpl->m_transactions.push_back(signed_transaction);
+    if (m_pimpl->m_index_loaded)
+        m_pimpl->index_push_back(signed_transaction);
 }
 
 void transaction_pool::pop_back()
 {
     m_pimpl->m_transactions.pop_back();
+    if (m_pimpl->m_index_loaded)
+        m_pimpl->index_pop_back();
 }
 
 BlockchainMessage::SignedTransaction const& transaction_pool::at(size_t index) const
@@ -84,6 +121,18 @@ size_t transaction_pool::length() const
     return m_pimpl->m_transactions.size();
 }
 
+bool transaction_pool::find(string const& transaction_hash, size_t& index) const
+{
+    m_pimpl->load_index();
+
+    auto it = m_pimpl->m_index.find(transaction_hash);
+    if (it == m_pimpl->m_index.end())
+        return false;
+
+    index = it->second;
+    return true;
+}
+
 void load_transaction_cache(publiqpp::detail::node_internals& impl,
                             bool only_pool)
 {
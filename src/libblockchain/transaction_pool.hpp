@@ -35,6 +35,7 @@ public:
     void pop_back();
     BlockchainMessage::SignedTransaction const& at(size_t index) const;
     BlockchainMessage::SignedTransaction& ref_at(size_t index) const;
+    bool find(std::string const& transaction_hash, size_t& index) const;
 
 private:
     std::unique_ptr<detail::transaction_pool_internals> m_pimpl;
@@ -6,11 +6,13 @@
 #include <mesh.pp/cryptoutility.hpp>
 
 #include <algorithm>
+#include <unordered_map>
 #include <unordered_set>
 
 using namespace BlockchainMessage;
 using std::string;
 using std::vector;
+using std::unordered_map;
 using std::unordered_set;
 
 namespace publiqpp
@@ -298,4 +300,192 @@ void action_revert(publiqpp::detail::node_internals& /*impl*/,
                    state_layer/* layer*/)
 {
 }
+
+namespace
+{
+uint64_t dictionary_index(unordered_map<string, uint64_t>& indexes,
+                          vector<string>& values,
+                          string const& value)
+{
+    auto insert_result = indexes.insert({value, uint64_t(values.size())});
+    if (insert_result.second)
+        values.push_back(value);
+
+    return insert_result.first->second;
+}
+
+class compact_reader
+{
+public:
+    compact_reader(vector<uint64_t> const& items)
+        : it(items.begin())
+        , it_end(items.end())
+    {}
+
+    bool empty() const
+    {
+        return it == it_end;
+    }
+
+    uint64_t next()
+    {
+        if (it == it_end)
+            throw wrong_data_exception("compact statistics are truncated");
+
+        return *it++;
+    }
+
+    string const& next(vector<string> const& values)
+    {
+        uint64_t index = next();
+        if (index >= values.size())
+            throw wrong_data_exception("compact statistics index is out of range");
+
+        return values[index];
+    }
+private:
+    vector<uint64_t>::const_iterator it;
+    vector<uint64_t>::const_iterator it_end;
+};
+}
+
+CompactServiceStatistics compress_statistics(ServiceStatistics const& service_statistics)
+{
+    CompactServiceStatistics result;
+    result.server_address = service_statistics.server_address;
+    result.start_time_point = service_statistics.start_time_point;
+    result.end_time_point = service_statistics.end_time_point;
+
+    unordered_map<string, uint64_t> file_indexes, unit_indexes, peer_indexes;
+
+    for (auto const& file_item : service_statistics.file_items)
+    {
+        result.items.push_back(dictionary_index(file_indexes, result.file_uris, file_item.file_uri));
+        result.items.push_back(dictionary_index(unit_indexes, result.unit_uris, file_item.unit_uri));
+        result.items.push_back(file_item.count_items.size());
+
+        for (auto const& count_item : file_item.count_items)
+        {
+            result.items.push_back(dictionary_index(peer_indexes, result.peer_addresses, count_item.peer_address));
+            result.items.push_back(count_item.count);
+        }
+    }
+
+    return result;
+}
+
+ServiceStatistics expand_statistics(CompactServiceStatistics const& compact_statistics)
+{
+    ServiceStatistics result;
+    result.server_address = compact_statistics.server_address;
+    result.start_time_point = compact_statistics.start_time_point;
+    result.end_time_point = compact_statistics.end_time_point;
+
+    compact_reader reader(compact_statistics.items);
+    while (false == reader.empty())
+    {
+        ServiceStatisticsFile file_item;
+        file_item.file_uri = reader.next(compact_statistics.file_uris);
+        file_item.unit_uri = reader.next(compact_statistics.unit_uris);
+
+        uint64_t count_items_size = reader.next();
+        for (uint64_t index = 0; index != count_items_size; ++index)
+        {
+            ServiceStatisticsCount count_item;
+            count_item.peer_address = reader.next(compact_statistics.peer_addresses);
+            count_item.count = reader.next();
+
+            file_item.count_items.push_back(std::move(count_item));
+        }
+
+        result.file_items.push_back(std::move(file_item));
+    }
+
+    return result;
+}
+
+bool compact_statistics_active(publiqpp::detail::node_internals const& impl)
+{
+    return impl.m_testnet ||
+           impl.m_blockchain.length() >= COMPACT_STATISTICS_ACTIVATION_BLOCK;
+}
+
+ServiceStatistics const* get_service_statistics(beltpp::packet const& action,
+                                                ServiceStatistics& expanded)
+{
+    if (action.type() == ServiceStatistics::rtt)
+    {
+        ServiceStatistics const* paction;
+        action.get(paction);
+        return paction;
+    }
+    else if (action.type() == CompactServiceStatistics::rtt)
+    {
+        CompactServiceStatistics const* paction;
+        action.get(paction);
+        expanded = expand_statistics(*paction);
+        return &expanded;
+    }
+
+    return nullptr;
+}
+
+vector<string> action_owners(CompactServiceStatistics const& compact_statistics)
+{
+    return {compact_statistics.server_address};
+}
+vector<string> action_participants(CompactServiceStatistics const& compact_statistics)
+{
+    return action_participants(expand_statistics(compact_statistics));
+}
+
+void action_validate(SignedTransaction const& signed_transaction,
+                     CompactServiceStatistics const& compact_statistics,
+                     bool check_complete)
+{
+    action_validate(signed_transaction,
+                    expand_statistics(compact_statistics),
+                    check_complete);
+}
+
+bool action_is_complete(SignedTransaction const&/* signed_transaction*/,
+                        CompactServiceStatistics const&/* compact_statistics*/)
+{
+    return true;
+}
+
+bool action_can_apply(publiqpp::detail::node_internals const& impl,
+                      SignedTransaction const& signed_transaction,
+                      CompactServiceStatistics const& compact_statistics,
+                      state_layer layer)
+{
+    if (false == compact_statistics_active(impl))
+        return false;
+
+    return action_can_apply(impl,
+                            signed_transaction,
+                            expand_statistics(compact_statistics),
+                            layer);
+}
+
+void action_apply(publiqpp::detail::node_internals& impl,
+                  SignedTransaction const& signed_transaction,
+                  CompactServiceStatistics const& compact_statistics,
+                  state_layer layer)
+{
+    if (false == compact_statistics_active(impl))
+        throw wrong_data_exception("compact service statistics are not active yet");
+
+    action_apply(impl,
+                 signed_transaction,
+                 expand_statistics(compact_statistics),
+                 layer);
+}
+
+void action_revert(publiqpp::detail::node_internals& /*impl*/,
+                   SignedTransaction const&/* signed_transaction*/,
+                   CompactServiceStatistics const& /*compact_statistics*/,
+                   state_layer/* layer*/)
+{
+}
 }
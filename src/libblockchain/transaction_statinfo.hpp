@@ -35,4 +35,42 @@ void action_revert(publiqpp::detail::node_internals& impl,
                    BlockchainMessage::SignedTransaction const& signed_transaction,
                    BlockchainMessage::ServiceStatistics const& service_statistics,
                    state_layer layer);
+
+//  dictionary encoded form of ServiceStatistics, same content
+BlockchainMessage::CompactServiceStatistics compress_statistics(BlockchainMessage::ServiceStatistics const& service_statistics);
+BlockchainMessage::ServiceStatistics expand_statistics(BlockchainMessage::CompactServiceStatistics const& compact_statistics);
+
+//  reads either encoding, nullptr if the action is not a statistics report
+//  a plain report is returned in place, a compact one is expanded into expanded
+BLOCKCHAINSHARED_EXPORT
+BlockchainMessage::ServiceStatistics const* get_service_statistics(beltpp::packet const& action,
+                                                                   BlockchainMessage::ServiceStatistics& expanded);
+
+//  whether the block being built or applied may carry CompactServiceStatistics
+bool compact_statistics_active(publiqpp::detail::node_internals const& impl);
+
+std::vector<std::string> action_owners(BlockchainMessage::CompactServiceStatistics const& compact_statistics);
+std::vector<std::string> action_participants(BlockchainMessage::CompactServiceStatistics const& compact_statistics);
+
+void action_validate(BlockchainMessage::SignedTransaction const& signed_transaction,
+                     BlockchainMessage::CompactServiceStatistics const& compact_statistics,
+                     bool check_complete);
+
+bool action_is_complete(BlockchainMessage::SignedTransaction const& signed_transaction,
+                        BlockchainMessage::CompactServiceStatistics const& compact_statistics);
+
+bool action_can_apply(publiqpp::detail::node_internals const& impl,
+                      BlockchainMessage::SignedTransaction const& signed_transaction,
+                      BlockchainMessage::CompactServiceStatistics const& compact_statistics,
+                      state_layer layer);
+
+void action_apply(publiqpp::detail::node_internals& impl,
+                  BlockchainMessage::SignedTransaction const& signed_transaction,
+                  BlockchainMessage::CompactServiceStatistics const& compact_statistics,
+                  state_layer layer);
+
+void action_revert(publiqpp::detail::node_internals& impl,
+                   BlockchainMessage::SignedTransaction const& signed_transaction,
+                   BlockchainMessage::CompactServiceStatistics const& compact_statistics,
+                   state_layer layer);
 }
@@ -0,0 +1,214 @@
+#include "transaction_verifier.hpp"
+
+#include <mesh.pp/cryptoutility.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace BlockchainMessage;
+using std::string;
+using std::vector;
+using std::unique_ptr;
+
+namespace publiqpp
+{
+namespace detail
+{
+namespace
+{
+bool broadcast_transaction(beltpp::packet& package, SignedTransaction*& p_signed_transaction)
+{
+    if (package.type() != Broadcast::rtt)
+        return false;
+
+    Broadcast* p_broadcast = nullptr;
+    package.get(p_broadcast);
+
+    if (p_broadcast->package.type() != SignedTransaction::rtt)
+        return false;
+
+    p_broadcast->package.get(p_signed_transaction);
+    return true;
+}
+
+//  same signature checks as signed_transaction_validate does
+bool verify_signatures(SignedTransaction const& signed_transaction)
+{
+    try
+    {
+        string signed_message = signed_transaction.transaction_details.to_string();
+        for (auto const& authority : signed_transaction.authorizations)
+        {
+            meshpp::public_key pb_key(authority.address);
+            meshpp::signature signature_check(pb_key, signed_message, authority.signature);
+        }
+    }
+    catch (std::exception const&)
+    {
+        //  the node loop will check again and report the error as usual
+        return false;
+    }
+
+    return (false == signed_transaction.authorizations.empty());
+}
+}
+
+class transaction_verifier_internals
+{
+public:
+    class entry
+    {
+    public:
+        wait_result_item item;
+        bool pending = false;
+        string verified_key;
+    };
+
+    transaction_verifier_internals(beltpp::event_handler& eh)
+        : m_peh(&eh)
+    {}
+
+    void run()
+    {
+        while (true)
+        {
+            entry* p_entry = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this]
+                {
+                    return m_stop || false == m_tasks.empty();
+                });
+
+                if (m_stop)
+                    return;
+
+                p_entry = m_tasks.front();
+                m_tasks.pop_front();
+            }
+
+            //  the node loop does not touch a pending entry
+            SignedTransaction* p_signed_transaction = nullptr;
+            broadcast_transaction(p_entry->item.packet, p_signed_transaction);
+
+            string verified_key;
+            if (verify_signatures(*p_signed_transaction))
+                verified_key = meshpp::hash(p_signed_transaction->to_string());
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                p_entry->verified_key = std::move(verified_key);
+                p_entry->pending = false;
+            }
+            m_peh->wake();
+        }
+    }
+
+    beltpp::event_handler* m_peh;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop = false;
+    std::deque<entry*> m_tasks;
+    //  in the order received, owned by the node loop
+    std::deque<unique_ptr<entry>> m_entries;
+
+    std::unordered_set<string> m_verified;
+    vector<std::thread> m_threads;
+};
+
+transaction_verifier::transaction_verifier(beltpp::event_handler& eh)
+    : m_pimpl(new transaction_verifier_internals(eh))
+{
+    size_t count = std::thread::hardware_concurrency();
+    count = std::max(size_t(1), std::min(size_t(TRANSACTION_VERIFIER_MAX_THREADS), count > 1 ? count - 1 : count));
+
+    auto* pimpl = m_pimpl.get();
+    for (size_t index = 0; index != count; ++index)
+        m_pimpl->m_threads.emplace_back([pimpl]{ pimpl->run(); });
+}
+
+transaction_verifier::~transaction_verifier()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pimpl->m_mutex);
+        m_pimpl->m_stop = true;
+    }
+    m_pimpl->m_condition.notify_all();
+
+    for (auto& thread : m_pimpl->m_threads)
+        thread.join();
+}
+
+void transaction_verifier::push(wait_result_item&& item)
+{
+    unique_ptr<transaction_verifier_internals::entry> p_entry(new transaction_verifier_internals::entry());
+    p_entry->item = std::move(item);
+
+    SignedTransaction* p_signed_transaction = nullptr;
+    bool verify = broadcast_transaction(p_entry->item.packet, p_signed_transaction);
+
+    std::lock_guard<std::mutex> lock(m_pimpl->m_mutex);
+
+    if (verify)
+    {
+        p_entry->pending = true;
+        m_pimpl->m_tasks.push_back(p_entry.get());
+        m_pimpl->m_condition.notify_one();
+    }
+
+    m_pimpl->m_entries.push_back(std::move(p_entry));
+}
+
+bool transaction_verifier::pop(wait_result_item& item)
+{
+    auto& entries = m_pimpl->m_entries;
+    std::unordered_set<beltpp::socket::peer_id> blocked_peers;
+
+    std::lock_guard<std::mutex> lock(m_pimpl->m_mutex);
+
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        auto& p_entry = *it;
+
+        //  a peer's packets wait behind its own pending ones
+        if (p_entry->pending)
+        {
+            blocked_peers.insert(p_entry->item.peerid);
+            continue;
+        }
+        if (blocked_peers.count(p_entry->item.peerid))
+            continue;
+
+        if (false == p_entry->verified_key.empty())
+        {
+            if (m_pimpl->m_verified.size() >= TRANSACTION_VERIFIER_MAX_VERIFIED)
+                m_pimpl->m_verified.clear();
+            m_pimpl->m_verified.insert(std::move(p_entry->verified_key));
+        }
+
+        item = std::move(p_entry->item);
+        entries.erase(it);
+
+        return true;
+    }
+
+    return false;
+}
+
+bool transaction_verifier::take_verified(SignedTransaction const& signed_transaction)
+{
+    //  the node loop is the only one using this set
+    if (m_pimpl->m_verified.empty())
+        return false;
+
+    return m_pimpl->m_verified.erase(meshpp::hash(signed_transaction.to_string())) > 0;
+}
+}
+}
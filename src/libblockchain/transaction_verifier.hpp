@@ -0,0 +1,36 @@
+#pragma once
+
+#include "global.hpp"
+#include "message.hpp"
+#include "common.hpp"
+
+#include <belt.pp/event.hpp>
+
+#include <memory>
+
+namespace publiqpp
+{
+namespace detail
+{
+class transaction_verifier_internals;
+
+//  checks the signatures of broadcast transactions on worker threads while
+//  the node loop goes on, and hands the received packets back to the loop
+//  in the order each peer sent them
+class transaction_verifier
+{
+public:
+    transaction_verifier(beltpp::event_handler& eh);
+    ~transaction_verifier();
+
+    void push(wait_result_item&& item);
+    bool pop(wait_result_item& item);
+
+    //  true once for a transaction whose signatures were already checked
+    bool take_verified(BlockchainMessage::SignedTransaction const& signed_transaction);
+
+private:
+    std::unique_ptr<transaction_verifier_internals> m_pimpl;
+};
+}
+}
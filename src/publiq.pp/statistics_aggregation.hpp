@@ -0,0 +1,2 @@
+#pragma once
+#include "../libblockchain/statistics_aggregation.hpp"
@@ -0,0 +1,2 @@
+#pragma once
+#include "../libblockchain/transaction_statinfo.hpp"
@@ -145,32 +145,33 @@ private:
     std::exception_ptr eptr;
 };
 
-uint64_t counts_per_channel_views(std::map<uint64_t, std::map<string, std::map<string, uint64_t>>> const& item_per_owner,
+uint64_t counts_per_channel_views(std::vector<std::pair<uint64_t, uint64_t>> const& content_views,
                                   uint64_t block_number,
                                   bool is_testnet)
 {
     uint64_t count = 0;
-    for (auto const& item_per_content_id : item_per_owner)
+    uint64_t max_count_per_content_id = 0;
+    for (auto it = content_views.begin(); it != content_views.end(); ++it)
     {
-        uint64_t max_count_per_content_id = 0;
-        for (auto const& item_per_unit : item_per_content_id.second)
-        for (auto const& item_per_file : item_per_unit.second)
+        if (false == is_testnet &&
+            (
+                block_number == 30335 ||
+                block_number == 30438 ||
+                block_number == 30346 ||
+                block_number == 30460 ||
+                block_number == 30463 ||
+                block_number == 30478
+            ))
+            max_count_per_content_id = std::max(count, it->second);
+        else
+            max_count_per_content_id = std::max(max_count_per_content_id, it->second);
+
+        if (it + 1 == content_views.end() ||
+            (it + 1)->first != it->first)
         {
-            if (false == is_testnet &&
-                (
-                    block_number == 30335 ||
-                    block_number == 30438 ||
-                    block_number == 30346 ||
-                    block_number == 30460 ||
-                    block_number == 30463 ||
-                    block_number == 30478
-                ))
-                max_count_per_content_id = std::max(count, item_per_file.second);
-            else
-                max_count_per_content_id = std::max(max_count_per_content_id, item_per_file.second);
+            count += max_count_per_content_id;
+            max_count_per_content_id = 0;
         }
-
-        count += max_count_per_content_id;
     }
 
     return count;
@@ -0,0 +1,300 @@
+#include <publiq.pp/message.hpp>
+#include <publiq.pp/coin.hpp>
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace BlockchainMessage;
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::map;
+using std::multimap;
+using std::pair;
+using std::vector;
+namespace chrono = std::chrono;
+using std::chrono::steady_clock;
+
+//  the coin implementation before the inline fast paths,
+//  kept here as the reference the new one must agree with
+class legacy_coin
+{
+public:
+    legacy_coin() : whole(0), fraction(0) {}
+    legacy_coin(uint64_t whole, uint64_t fraction)
+        : whole(whole)
+        , fraction(fraction)
+    {
+        if (fraction >= fractions_in_whole)
+            throw std::runtime_error("invalid coin amount");
+    }
+    template <typename Coin>
+    legacy_coin(Coin const& other)
+        : legacy_coin(other.whole, other.fraction) {}
+
+    template <typename Coin>
+    void to_Coin(Coin& other) const
+    {
+        other.whole = whole;
+        other.fraction = fraction;
+    }
+
+    bool empty() const
+    {
+        return (whole == 0) && (fraction == 0);
+    }
+
+    legacy_coin& operator += (legacy_coin const& other)
+    {
+        fraction += other.fraction;
+        if (fraction >= fractions_in_whole)
+        {
+            ++whole;
+            fraction -= fractions_in_whole;
+        }
+        whole += other.whole;
+        return *this;
+    }
+    legacy_coin& operator -= (legacy_coin const& other)
+    {
+        if (whole < other.whole ||
+            (whole == other.whole && fraction < other.fraction))
+            throw std::runtime_error("cannot have negative result for coin");
+        if (fraction < other.fraction)
+        {
+            --whole;
+            fraction += fractions_in_whole;
+        }
+        fraction -= other.fraction;
+        whole -= other.whole;
+        return *this;
+    }
+    legacy_coin& operator *= (uint64_t times)
+    {
+        whole *= times;
+        fraction *= times;
+        whole += fraction / fractions_in_whole;
+        fraction = fraction % fractions_in_whole;
+        return *this;
+    }
+    legacy_coin& operator /= (uint64_t times)
+    {
+        if (0 == times) throw std::runtime_error("zero division");
+        fraction += whole % times * fractions_in_whole;
+        whole /= times;
+        fraction /= times;
+        return *this;
+    }
+
+    bool operator > (legacy_coin const& other) const
+    {
+        return whole > other.whole ||
+               (whole == other.whole && fraction > other.fraction);
+    }
+    bool operator < (legacy_coin const& other) const
+    {
+        return other > *this;
+    }
+
+    static const uint64_t fractions_in_whole = 100000000;
+
+private:
+    uint64_t whole;
+    uint64_t fraction;
+};
+
+legacy_coin operator + (legacy_coin first, legacy_coin const& second) { return first += second; }
+legacy_coin operator - (legacy_coin first, legacy_coin const& second) { return first -= second; }
+legacy_coin operator * (legacy_coin first, uint64_t times) { return first *= times; }
+legacy_coin operator / (legacy_coin first, uint64_t times) { return first /= times; }
+
+//  the same steps as distribute_rewards in communication_p2p.cpp
+template <typename coin_type>
+coin_type distribute_rewards(vector<Reward>& rewards,
+                             multimap<string, pair<uint64_t, uint64_t>> const& stat_distribution,
+                             coin_type total_amount,
+                             RewardType reward_type)
+{
+    if (stat_distribution.size() == 0 || total_amount.empty())
+        return total_amount;
+
+    coin_type rest_amount = total_amount;
+    map<string, coin_type> coin_distribution;
+    for (auto const& item : stat_distribution)
+    {
+        coin_type amount = (total_amount * item.second.first) / item.second.second;
+
+        rest_amount -= amount;
+        coin_distribution[item.first] += amount;
+    }
+
+    Reward reward;
+    reward.reward_type = reward_type;
+
+    for (auto const& item : coin_distribution)
+    {
+        reward.to = item.first;
+        item.second.to_Coin(reward.amount);
+
+        rewards.push_back(reward);
+    }
+
+    if (rest_amount > coin_type(0, 0))
+        (rest_amount + rewards.back().amount).to_Coin(rewards.back().amount);
+
+    return coin_type();
+}
+
+//  the same steps as state::increase_balance and state::decrease_balance
+//  the balances are kept as Coin, as they are stored
+template <typename coin_type>
+void apply_transfers(map<string, Coin>& accounts,
+                     vector<pair<pair<string, string>, Coin>> const& transfers)
+{
+    for (auto const& transfer : transfers)
+    {
+        coin_type amount = transfer.second;
+
+        Coin& from_balance = accounts[transfer.first.first];
+        if (coin_type(from_balance) < amount)
+            continue;
+        (coin_type(from_balance) - amount).to_Coin(from_balance);
+
+        Coin& to_balance = accounts[transfer.first.second];
+        (coin_type(to_balance) + amount).to_Coin(to_balance);
+    }
+}
+
+bool equal(Coin const& first, Coin const& second)
+{
+    return first.whole == second.whole && first.fraction == second.fraction;
+}
+
+//  runs the reward distribution and balance updates with both coin
+//  implementations over the same random input, checks that every
+//  amount is identical and reports the time spent in each
+int main(int argc, char** argv)
+{
+    try
+    {
+    size_t rounds = 1000;
+    if (argc > 1)
+        rounds = std::stoul(argv[1]);
+
+    size_t account_count = 1000;
+    if (argc > 2)
+        account_count = std::stoul(argv[2]);
+
+    std::mt19937_64 generator(1);
+
+    vector<string> addresses;
+    for (size_t index = 0; index != account_count; ++index)
+        addresses.push_back("address" + std::to_string(index));
+
+    //  shares as validate_statistics produces them, count over 2 * total
+    vector<multimap<string, pair<uint64_t, uint64_t>>> distributions(rounds);
+    vector<Coin> totals(rounds);
+    for (size_t round = 0; round != rounds; ++round)
+    {
+        vector<uint64_t> counts(1 + generator() % 100);
+        uint64_t total = 0;
+        for (auto& count : counts)
+        {
+            count = 1 + generator() % 100000;
+            total += count;
+        }
+
+        for (auto const& count : counts)
+            distributions[round].insert({addresses[generator() % account_count], {count, 2 * total}});
+
+        totals[round].whole = generator() % 10000;
+        totals[round].fraction = generator() % legacy_coin::fractions_in_whole;
+    }
+
+    vector<pair<pair<string, string>, Coin>> transfers(rounds * 100);
+    map<string, Coin> legacy_accounts;
+    for (auto const& address : addresses)
+    {
+        Coin balance;
+        balance.whole = generator() % 1000000;
+        legacy_accounts[address] = balance;
+    }
+    for (auto& transfer : transfers)
+    {
+        transfer.first.first = addresses[generator() % account_count];
+        transfer.first.second = addresses[generator() % account_count];
+        transfer.second.whole = generator() % 1000;
+        transfer.second.fraction = generator() % legacy_coin::fractions_in_whole;
+    }
+    map<string, Coin> accounts = legacy_accounts;
+
+    vector<Reward> legacy_rewards, rewards;
+
+    steady_clock::time_point start = steady_clock::now();
+    for (size_t round = 0; round != rounds; ++round)
+        distribute_rewards<legacy_coin>(legacy_rewards, distributions[round], legacy_coin(totals[round]), RewardType::channel);
+    steady_clock::duration legacy_rewards_duration = steady_clock::now() - start;
+
+    start = steady_clock::now();
+    for (size_t round = 0; round != rounds; ++round)
+        distribute_rewards<publiqpp::coin>(rewards, distributions[round], publiqpp::coin(totals[round]), RewardType::channel);
+    steady_clock::duration rewards_duration = steady_clock::now() - start;
+
+    start = steady_clock::now();
+    apply_transfers<legacy_coin>(legacy_accounts, transfers);
+    steady_clock::duration legacy_balances_duration = steady_clock::now() - start;
+
+    start = steady_clock::now();
+    apply_transfers<publiqpp::coin>(accounts, transfers);
+    steady_clock::duration balances_duration = steady_clock::now() - start;
+
+    if (legacy_rewards.size() != rewards.size())
+    {
+        cout << "reward counts differ" << endl;
+        return 1;
+    }
+    for (size_t index = 0; index != rewards.size(); ++index)
+    {
+        if (legacy_rewards[index].to != rewards[index].to ||
+            false == equal(legacy_rewards[index].amount, rewards[index].amount))
+        {
+            cout << "rewards differ at " << index << endl;
+            return 1;
+        }
+    }
+    for (auto const& account : accounts)
+    {
+        if (false == equal(account.second, legacy_accounts[account.first]))
+        {
+            cout << "balances differ for " << account.first << endl;
+            return 1;
+        }
+    }
+
+    cout << rewards.size() << " rewards, " << transfers.size() << " transfers, identical results" << endl;
+    cout << "distribute_rewards, legacy: "
+         << chrono::duration_cast<chrono::microseconds>(legacy_rewards_duration).count()
+         << " microseconds, coin: "
+         << chrono::duration_cast<chrono::microseconds>(rewards_duration).count()
+         << " microseconds" << endl;
+    cout << "balances, legacy: "
+         << chrono::duration_cast<chrono::microseconds>(legacy_balances_duration).count()
+         << " microseconds, coin: "
+         << chrono::duration_cast<chrono::microseconds>(balances_duration).count()
+         << " microseconds" << endl;
+    }
+    catch(std::exception const& e)
+    {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <publiq.pp/message.hpp>
+#include <publiq.pp/message.tmpl.hpp>
+
+#include <belt.pp/socket.hpp>
+
+#include <mesh.pp/cryptoutility.hpp>
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+using namespace BlockchainMessage;
+using peer_id = beltpp::socket::peer_id;
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+namespace chrono = std::chrono;
+using std::chrono::system_clock;
+using std::chrono::steady_clock;
+
+using sf = beltpp::socket_family_t<&message_list_load>;
+
+//  measures end to end transactions per second through the rpc interface,
+//  signed transfers are prepared up front and kept in flight "window" at a time
+int main(int argc, char** argv)
+{
+    try
+    {
+    if (argc < 4)
+    {
+        cout << "usage: test_rpc_throughput address:port private_key to_address [count] [window]" << endl;
+        return 0;
+    }
+
+    beltpp::ip_address address;
+    address.from_string(argv[1]);
+    if (address.remote.empty())
+    {
+        address.remote = address.local;
+        address.local = beltpp::ip_destination();
+    }
+
+    meshpp::private_key pv(argv[2]);
+    string to_address = argv[3];
+
+    size_t count = 1000;
+    if (argc > 4)
+        count = std::stoul(argv[4]);
+
+    size_t window = 100;
+    if (argc > 5)
+        window = std::stoul(argv[5]);
+
+    string from_address = pv.get_public_key().to_string();
+
+    vector<Broadcast> broadcasts;
+    broadcasts.reserve(count);
+    for (size_t index = 0; index != count; ++index)
+    {
+        Transfer transfer;
+        transfer.from = from_address;
+        transfer.to = to_address;
+        //  every transaction has to be unique
+        transfer.amount.fraction = index + 1;
+
+        Transaction transaction;
+        transaction.creation.tm = system_clock::to_time_t(system_clock::now());
+        transaction.expiry.tm = system_clock::to_time_t(system_clock::now() + chrono::hours(1));
+        transaction.action = transfer;
+
+        Authority authorization;
+        authorization.address = from_address;
+        authorization.signature = pv.sign(transaction.to_string()).base58;
+
+        SignedTransaction signed_transaction;
+        signed_transaction.authorizations.push_back(authorization);
+        signed_transaction.transaction_details = transaction;
+
+        Broadcast broadcast;
+        broadcast.echoes = 2;
+        broadcast.package = signed_transaction;
+
+        broadcasts.push_back(std::move(broadcast));
+    }
+
+    beltpp::event_handler eh;
+    beltpp::socket sk = beltpp::getsocket<sf>(eh);
+    eh.add(sk);
+
+    sk.open(address);
+
+    peer_id peerid;
+    std::unordered_set<beltpp::ievent_item const*> set_items;
+
+    while (peerid.empty())
+    {
+        beltpp::isocket::packets packets;
+        if (beltpp::ievent_handler::wait_result::event & eh.wait(set_items))
+            packets = sk.receive(peerid);
+
+        for (auto const& packet : packets)
+        {
+            if (packet.type() != beltpp::isocket_join::rtt)
+                throw std::runtime_error("cannot connect, received: " + std::to_string(packet.type()));
+        }
+    }
+
+    size_t sent = 0, done = 0, failed = 0;
+    steady_clock::time_point start = steady_clock::now();
+
+    while (done + failed < count)
+    {
+        while (sent < count && sent - done - failed < window)
+        {
+            sk.send(peerid, beltpp::packet(std::move(broadcasts[sent])));
+            ++sent;
+        }
+
+        beltpp::isocket::packets packets;
+        peer_id received_peerid;
+        if (beltpp::ievent_handler::wait_result::event & eh.wait(set_items))
+            packets = sk.receive(received_peerid);
+
+        for (auto const& packet : packets)
+        {
+            if (packet.type() == Done::rtt)
+                ++done;
+            else if (packet.type() == beltpp::isocket_drop::rtt)
+                throw std::runtime_error("server disconnected");
+            else
+                ++failed;
+        }
+    }
+
+    auto duration = chrono::duration_cast<chrono::milliseconds>(steady_clock::now() - start);
+
+    cout << done << " done, " << failed << " failed in "
+         << duration.count() << " milliseconds" << endl;
+    if (duration.count())
+        cout << (1000 * (done + failed) / size_t(duration.count())) << " transactions per second" << endl;
+    }
+    catch(std::exception const& e)
+    {
+        cout << "exception: " << e.what() << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,494 @@
+#include <publiq.pp/message.hpp>
+#include <publiq.pp/message.tmpl.hpp>
+#include <publiq.pp/statistics_aggregation.hpp>
+#include <publiq.pp/transaction_statinfo.hpp>
+
+#include <belt.pp/socket.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace BlockchainMessage;
+using peer_id = beltpp::socket::peer_id;
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::map;
+using std::set;
+using std::vector;
+using std::multimap;
+using std::pair;
+using std::unordered_map;
+namespace chrono = std::chrono;
+using std::chrono::steady_clock;
+
+using sf = beltpp::socket_family_t<&message_list_load>;
+
+using stat_result = multimap<string, pair<uint64_t, uint64_t>>;
+
+//  the nested maps implementation aggregate_statistics replaced,
+//  kept here as the reference the new one must agree with
+void reference_aggregate_statistics(map<string, ServiceStatistics> const& channel_provided_statistics,
+                                    map<string, ServiceStatistics> const& storage_provided_statistics,
+                                    publiqpp::statistics_lookup const& lookup,
+                                    uint64_t block_number,
+                                    stat_result& author_result,
+                                    stat_result& channel_result,
+                                    stat_result& storage_result,
+                                    map<string, map<string, uint64_t>>& map_unit_uri_view_counts)
+{
+    author_result.clear();
+    channel_result.clear();
+    storage_result.clear();
+
+    map_unit_uri_view_counts.clear();
+
+    map<string, map<string, map<string, uint64_t>>> channel_statistics;
+    map<string, map<string, set<string>>> cross_verified_statistics;
+
+    for (auto const& stat_item : channel_provided_statistics)
+    for (auto const& file_item : stat_item.second.file_items)
+    for (auto const& count_item : file_item.count_items)
+        channel_statistics[stat_item.first][file_item.file_uri][count_item.peer_address] += count_item.count;
+
+    for (auto const& stat_item : storage_provided_statistics)
+    for (auto const& file_item : stat_item.second.file_items)
+    for (auto const& count_item : file_item.count_items)
+    {
+        uint64_t stat_value = channel_statistics[count_item.peer_address][file_item.file_uri][stat_item.first];
+
+        if (stat_value > 0 &&
+            false == publiqpp::stat_mismatch(stat_value, count_item.count))
+            cross_verified_statistics[count_item.peer_address][file_item.file_uri].insert(stat_item.first);
+    }
+
+    map<string, uint64_t> storage_group;
+    map<string, map<string, uint64_t>> author_group;
+    map<string, map<string, map<uint64_t, map<string, map<string, uint64_t>>>>> content_group;
+
+    for (auto const& stat_item : channel_provided_statistics)
+    for (auto const& file_item : stat_item.second.file_items)
+    for (auto const& count_item : file_item.count_items)
+    {
+        if (cross_verified_statistics[stat_item.first][file_item.file_uri].count(count_item.peer_address))
+        {
+            storage_group[count_item.peer_address] += count_item.count;
+            author_group[file_item.unit_uri][file_item.file_uri] += count_item.count;
+
+            ContentUnit content_unit = lookup.get_unit(file_item.unit_uri);
+            content_group[stat_item.first]
+                    [content_unit.channel_address]
+                    [content_unit.content_id]
+                    [file_item.unit_uri]
+                    [file_item.file_uri] += count_item.count;
+        }
+    }
+
+    uint64_t total_view_all_files_count = 0;
+    for (auto const& item : storage_group)
+    {
+        total_view_all_files_count += item.second;
+        storage_result.insert({item.first, {item.second, 1}});
+    }
+
+    for (auto& item_result : storage_result)
+        item_result.second.second *= total_view_all_files_count;
+
+    uint64_t total_view_units_count = 0;
+    for (auto const& item_per_unit : author_group)
+    {
+        uint64_t total = 0;
+        uint64_t file_count = item_per_unit.second.size();
+        for (auto const& item_per_file : item_per_unit.second)
+            total += item_per_file.second;
+
+        total /= file_count;
+        total_view_units_count += total;
+
+        for (auto const& item_per_file : item_per_unit.second)
+        {
+            File file = lookup.get_file(item_per_file.first);
+            uint64_t authors_count = file.author_addresses.size();
+
+            for (auto const& author_address : file.author_addresses)
+                author_result.insert({author_address, {total, file_count * authors_count}});
+        }
+    }
+
+    for (auto& item_result : author_result)
+        item_result.second.second *= total_view_units_count;
+
+    uint64_t total_channel_view_count = 0;
+    for (auto const& item_per_server : content_group)
+    {
+        string const& serving_channel = item_per_server.first;
+
+        for (auto const& item_per_owner : item_per_server.second)
+        {
+            string const& owner_channel = item_per_owner.first;
+
+            for (auto const& item_per_content_id : item_per_owner.second)
+            for (auto const& item_per_unit : item_per_content_id.second)
+            {
+                auto& unit_value = map_unit_uri_view_counts[item_per_unit.first][serving_channel];
+
+                for (auto const& item_per_file : item_per_unit.second)
+                    unit_value = std::max(unit_value, item_per_file.second);
+            }
+
+            uint64_t count = 0;
+            if (lookup.counts_per_channel_views)
+            {
+                vector<pair<uint64_t, uint64_t>> content_views;
+                for (auto const& item_per_content_id : item_per_owner.second)
+                for (auto const& item_per_unit : item_per_content_id.second)
+                for (auto const& item_per_file : item_per_unit.second)
+                    content_views.push_back({item_per_content_id.first, item_per_file.second});
+
+                count = lookup.counts_per_channel_views(content_views,
+                                                        block_number,
+                                                        lookup.testnet);
+            }
+            else
+            {
+                for (auto const& item_per_content_id : item_per_owner.second)
+                {
+                    uint64_t max_count_per_content_id = 0;
+                    for (auto const& item_per_unit : item_per_content_id.second)
+                    for (auto const& item_per_file : item_per_unit.second)
+                        max_count_per_content_id = std::max(max_count_per_content_id, item_per_file.second);
+                    count += max_count_per_content_id;
+                }
+            }
+
+            if (serving_channel == owner_channel)
+            {
+                channel_result.insert({serving_channel, {2 * count, 2}});
+            }
+            else
+            {
+                channel_result.insert({owner_channel, {count, 2}});
+                channel_result.insert({serving_channel, {count, 2}});
+            }
+
+            total_channel_view_count += count;
+        }
+    }
+
+    for (auto& item_result : channel_result)
+        item_result.second.second *= total_channel_view_count;
+}
+
+void Send(beltpp::packet&& send_package,
+          beltpp::packet& receive_package,
+          beltpp::socket& sk,
+          peer_id const& peerid,
+          beltpp::event_handler& eh);
+
+//  replays the service statistics of a block range from a node's action log
+//  through both implementations, checks that the shares are identical
+//  for every thread count and reports the time spent in each
+//  the same as the one publiqd passes to the node, so that the
+//  measurements include the callback path taken in production
+uint64_t counts_per_channel_views(vector<pair<uint64_t, uint64_t>> const& content_views,
+                                  uint64_t block_number,
+                                  bool is_testnet)
+{
+    uint64_t count = 0;
+    uint64_t max_count_per_content_id = 0;
+    for (auto it = content_views.begin(); it != content_views.end(); ++it)
+    {
+        if (false == is_testnet &&
+            (
+                block_number == 30335 ||
+                block_number == 30438 ||
+                block_number == 30346 ||
+                block_number == 30460 ||
+                block_number == 30463 ||
+                block_number == 30478
+            ))
+            max_count_per_content_id = std::max(count, it->second);
+        else
+            max_count_per_content_id = std::max(max_count_per_content_id, it->second);
+
+        if (it + 1 == content_views.end() ||
+            (it + 1)->first != it->first)
+        {
+            count += max_count_per_content_id;
+            max_count_per_content_id = 0;
+        }
+    }
+
+    return count;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+    if (argc < 4)
+    {
+        cout << "usage: test_statistics_aggregation address:port start_block end_block [repeat]" << endl;
+        return 0;
+    }
+
+    beltpp::ip_address address;
+    address.from_string(argv[1]);
+    if (address.remote.empty())
+    {
+        address.remote = address.local;
+        address.local = beltpp::ip_destination();
+    }
+
+    uint64_t start_block = std::stoull(argv[2]);
+    uint64_t end_block = std::stoull(argv[3]);
+
+    size_t repeat = 10;
+    if (argc > 4)
+        repeat = std::stoul(argv[4]);
+
+    beltpp::event_handler eh;
+    beltpp::socket sk = beltpp::getsocket<sf>(eh);
+    eh.add(sk);
+
+    sk.open(address);
+
+    peer_id peerid;
+    std::unordered_set<beltpp::ievent_item const*> set_items;
+
+    while (peerid.empty())
+    {
+        beltpp::isocket::packets packets;
+        if (beltpp::ievent_handler::wait_result::event & eh.wait(set_items))
+            packets = sk.receive(peerid);
+
+        for (auto const& packet : packets)
+        {
+            if (packet.type() != beltpp::isocket_join::rtt)
+                throw std::runtime_error("cannot connect, received: " + std::to_string(packet.type()));
+        }
+    }
+
+    //  documents and roles as they are after each replayed block
+    unordered_map<string, ContentUnit> units;
+    unordered_map<string, File> files;
+    unordered_map<string, NodeType> roles;
+
+    publiqpp::statistics_lookup lookup;
+    lookup.get_unit = [&units](string const& uri) -> ContentUnit const&
+    {
+        return units.at(uri);
+    };
+    lookup.get_file = [&files](string const& uri) -> File const&
+    {
+        return files.at(uri);
+    };
+    lookup.counts_per_channel_views = &counts_per_channel_views;
+
+    //  the shares decide the rewards, so equal shares mean equal rewards
+    vector<size_t> const thread_counts = {1, 2, 4, 8};
+
+    size_t block_count = 0, statistics_count = 0;
+    steady_clock::duration reference_duration(0);
+    vector<steady_clock::duration> aggregate_durations(thread_counts.size(), steady_clock::duration(0));
+
+    uint64_t index = 0;
+    bool done = false;
+    while (false == done)
+    {
+        LoggedTransactionsRequest request;
+        request.start_index = index;
+        request.max_count = 1000;
+
+        beltpp::packet receive_package;
+        Send(beltpp::packet(request), receive_package, sk, peerid, eh);
+
+        if (receive_package.type() != LoggedTransactions::rtt)
+            throw std::runtime_error("unexpected response: " + receive_package.to_string());
+
+        LoggedTransactions logged_transactions;
+        std::move(receive_package).get(logged_transactions);
+
+        if (logged_transactions.actions.empty())
+            break;
+
+        for (auto const& logged_transaction : logged_transactions.actions)
+        {
+            index = logged_transaction.index + 1;
+
+            if (logged_transaction.action.type() != BlockLog::rtt)
+                continue;
+
+            BlockLog const* block_log;
+            logged_transaction.action.get(block_log);
+
+            if (block_log->block_number > end_block)
+            {
+                done = true;
+                break;
+            }
+
+            bool apply = (logged_transaction.logging_type == LoggingType::apply);
+
+            for (auto const& transaction_log : block_log->transactions)
+            {
+                if (transaction_log.action.type() == File::rtt)
+                {
+                    File const* file;
+                    transaction_log.action.get(file);
+                    if (apply)
+                        files[file->uri] = *file;
+                    else
+                        files.erase(file->uri);
+                }
+                else if (transaction_log.action.type() == ContentUnit::rtt)
+                {
+                    ContentUnit const* content_unit;
+                    transaction_log.action.get(content_unit);
+                    if (apply)
+                        units[content_unit->uri] = *content_unit;
+                    else
+                        units.erase(content_unit->uri);
+                }
+                else if (transaction_log.action.type() == Role::rtt)
+                {
+                    Role const* role;
+                    transaction_log.action.get(role);
+                    if (apply)
+                        roles[role->node_address] = role->node_type;
+                    else
+                        roles.erase(role->node_address);
+                }
+            }
+
+            if (false == apply ||
+                block_log->block_number < start_block)
+                continue;
+
+            map<string, ServiceStatistics> channel_provided_statistics;
+            map<string, ServiceStatistics> storage_provided_statistics;
+
+            for (auto const& transaction_log : block_log->transactions)
+            {
+                //  plain and compact reports alike
+                ServiceStatistics expanded_statistics;
+                ServiceStatistics const* service_statistics =
+                        publiqpp::get_service_statistics(transaction_log.action, expanded_statistics);
+                if (nullptr == service_statistics)
+                    continue;
+
+                auto it_role = roles.find(service_statistics->server_address);
+                if (it_role == roles.end())
+                    continue;
+
+                if (it_role->second == NodeType::channel)
+                    channel_provided_statistics[service_statistics->server_address] = *service_statistics;
+                else if (it_role->second == NodeType::storage)
+                    storage_provided_statistics[service_statistics->server_address] = *service_statistics;
+            }
+
+            if (channel_provided_statistics.empty())
+                continue;
+
+            ++block_count;
+            statistics_count += channel_provided_statistics.size() + storage_provided_statistics.size();
+
+            stat_result author_reference, channel_reference, storage_reference;
+            stat_result author_result, channel_result, storage_result;
+            map<string, map<string, uint64_t>> unit_uri_view_counts_reference, unit_uri_view_counts;
+
+            steady_clock::time_point start = steady_clock::now();
+            for (size_t count = 0; count != repeat; ++count)
+                reference_aggregate_statistics(channel_provided_statistics,
+                                               storage_provided_statistics,
+                                               lookup,
+                                               block_log->block_number,
+                                               author_reference,
+                                               channel_reference,
+                                               storage_reference,
+                                               unit_uri_view_counts_reference);
+            reference_duration += steady_clock::now() - start;
+
+            for (size_t thread_index = 0; thread_index != thread_counts.size(); ++thread_index)
+            {
+                lookup.threads = thread_counts[thread_index];
+
+                start = steady_clock::now();
+                for (size_t count = 0; count != repeat; ++count)
+                    publiqpp::aggregate_statistics(channel_provided_statistics,
+                                                   storage_provided_statistics,
+                                                   lookup,
+                                                   block_log->block_number,
+                                                   author_result,
+                                                   channel_result,
+                                                   storage_result,
+                                                   unit_uri_view_counts);
+                aggregate_durations[thread_index] += steady_clock::now() - start;
+
+                if (author_reference != author_result ||
+                    channel_reference != channel_result ||
+                    storage_reference != storage_result ||
+                    unit_uri_view_counts_reference != unit_uri_view_counts)
+                {
+                    cout << "results differ at block " << block_log->block_number
+                         << " with " << lookup.threads << " threads" << endl;
+                    return 1;
+                }
+            }
+        }
+    }
+
+    cout << block_count << " blocks, " << statistics_count << " statistics reports, identical results" << endl;
+    cout << "reference: "
+         << chrono::duration_cast<chrono::milliseconds>(reference_duration).count()
+         << " milliseconds" << endl;
+    for (size_t thread_index = 0; thread_index != thread_counts.size(); ++thread_index)
+        cout << "aggregate, " << thread_counts[thread_index] << " threads: "
+             << chrono::duration_cast<chrono::milliseconds>(aggregate_durations[thread_index]).count()
+             << " milliseconds" << endl;
+    }
+    catch(std::exception const& e)
+    {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+void Send(beltpp::packet&& send_package,
+          beltpp::packet& receive_package,
+          beltpp::socket& sk,
+          peer_id const& peerid,
+          beltpp::event_handler& eh)
+{
+    sk.send(peerid, std::move(send_package));
+
+    std::unordered_set<beltpp::ievent_item const*> set_items;
+    while (true)
+    {
+        beltpp::isocket::packets packets;
+        peer_id received_peerid;
+        if (beltpp::ievent_handler::wait_result::event & eh.wait(set_items))
+            packets = sk.receive(received_peerid);
+
+        if (packets.empty())
+            continue;
+
+        auto& packet = packets.front();
+
+        if (packet.type() == beltpp::isocket_drop::rtt)
+            throw std::runtime_error("server disconnected");
+
+        receive_package = std::move(packet);
+        break;
+    }
+}